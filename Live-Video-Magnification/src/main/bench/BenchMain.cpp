@@ -0,0 +1,581 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->BenchMain.cpp                                      */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+// Micro benchmarks of the magnification kernels on synthetic frames. Every kernel is timed
+// in isolation, state it depends on (pyramids, filter state, temporal matrices) is prepared
+// beforehand. Kernels that advance their state, like a filter or a ring buffer, keep
+// advancing it from run to run, as they do from frame to frame.
+
+// C++
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+// OpenCV
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+// Local
+#include "main/magnification/BreathExtractor.h"
+#include "main/magnification/LaplacePyramid.h"
+#include "main/magnification/Magnificator.h"
+#include "main/magnification/RieszPyramid.h"
+#include "main/magnification/SpatialFilter.h"
+#include "main/magnification/TemporalFilter.h"
+#include "main/other/Config.h"
+#include "main/other/Structures.h"
+
+struct BenchOptions {
+    std::vector<cv::Size> sizes;
+    std::string filter;
+    double minTime;
+    int levels;
+    double framerate;
+};
+
+struct BenchResult {
+    std::string kernel;
+    cv::Size size;
+    int channels;
+    int iterations;
+    double medianMs;
+    double minMs;
+};
+
+static void printUsage(const char *name)
+{
+    std::cerr
+        << "Usage: " << name << " [options]\n"
+        << "\n"
+        << "Options:\n"
+        << "  --sizes <WxH,...>        Frame sizes (default 640x480,1280x720,1920x1080,3840x2160)\n"
+        << "  --filter <text>          Only run kernels whose name contains text\n"
+        << "  --min-time <s>           Time spent per kernel and size (default 0.5)\n"
+        << "  --levels <n>             Pyramid levels, clamped to the maximum for the frame size (default "
+        << DEFAULT_LAP_MAG_LEVELS << ")\n"
+        << "  --fps <val>              Framerate for the temporal filters (default 30)\n"
+        << "  --csv <file>             Additionally write the results to a CSV file\n"
+        << "  --check                  Instead of timing, compare the streaming filters with their batch\n"
+        << "                           versions on the same frames, fails if they differ\n";
+}
+
+static bool parseSizes(const std::string &arg, std::vector<cv::Size> &sizes)
+{
+    sizes.clear();
+    size_t start = 0;
+    while(start < arg.size()) {
+        size_t end = arg.find(',', start);
+        if(end == std::string::npos)
+            end = arg.size();
+        int w = 0, h = 0;
+        if(sscanf(arg.substr(start, end-start).c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+            return false;
+        sizes.push_back(cv::Size(w, h));
+        start = end + 1;
+    }
+    return !sizes.empty();
+}
+
+// Random texture with some structure, scaled to [0,1] like the Magnificator's input
+static cv::Mat syntheticFrame(const cv::Size &size, int channels, int shift)
+{
+    cv::Mat noise(size, CV_8UC(channels));
+    cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(255));
+    cv::GaussianBlur(noise, noise, cv::Size(5,5), 0);
+
+    // Shift to get motion between consecutive frames
+    cv::Mat shifted;
+    cv::Mat M = (cv::Mat_<double>(2,3) << 1, 0, shift, 0, 1, 0);
+    cv::warpAffine(noise, shifted, M, size, cv::INTER_LINEAR, cv::BORDER_REFLECT_101);
+
+    cv::Mat frame;
+    shifted.convertTo(frame, CV_32FC(channels), 1.0/255.0);
+    return frame;
+}
+
+// Runs body until minTime is spent, at least 3 times
+template<typename Body>
+static BenchResult runKernel(const std::string &kernel, const cv::Size &size, int channels,
+                             const BenchOptions &options, Body body)
+{
+    typedef std::chrono::steady_clock Clock;
+    std::vector<double> durations;
+    double spent = 0;
+
+    // Warm up caches and OpenCV's internal buffers
+    body();
+
+    while(spent < options.minTime || durations.size() < 3) {
+        Clock::time_point start = Clock::now();
+        body();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        durations.push_back(ms);
+        spent += ms / 1000.0;
+    }
+
+    std::sort(durations.begin(), durations.end());
+    BenchResult result;
+    result.kernel = kernel;
+    result.size = size;
+    result.channels = channels;
+    result.iterations = static_cast<int>(durations.size());
+    result.medianMs = durations[durations.size()/2];
+    result.minMs = durations.front();
+    return result;
+}
+
+static void report(const BenchResult &result, std::vector<BenchResult> &results)
+{
+    printf("%-36s %5dx%-5d %-5s %8d %12.3f %12.3f\n", result.kernel.c_str(),
+           result.size.width, result.size.height, result.channels == 1 ? "gray" : "color",
+           result.iterations, result.medianMs, result.minMs);
+    fflush(stdout);
+    results.push_back(result);
+}
+
+static bool selected(const BenchOptions &options, const std::string &kernel)
+{
+    return options.filter.empty() || kernel.find(options.filter) != std::string::npos;
+}
+
+///////////////////////////////
+///Spatial and Temporal //////
+//////////////////////////////
+static void benchPyramids(const cv::Size &size, int channels, int levels, const BenchOptions &options,
+                          std::vector<BenchResult> &results)
+{
+    const cv::Mat frame = syntheticFrame(size, channels, 0);
+    vector<cv::Mat> pyr;
+    cv::Mat dst;
+
+    if(selected(options, "buildGaussPyrFromImg"))
+        report(runKernel("buildGaussPyrFromImg", size, channels, options,
+                         [&]() { buildGaussPyrFromImg(frame, levels, pyr); }), results);
+
+    // Color magnification output stage: the delta of the smallest Gauss level added to the 8bit frame
+    if(selected(options, "buildImgFromGaussPyr") || selected(options, "addGaussDelta")) {
+        vector<cv::Mat> gaussPyr, scratch;
+        buildGaussPyrFromImg(frame, levels, gaussPyr);
+        cv::Mat frame8u;
+        frame.convertTo(frame8u, CV_8U, 255.0);
+        if(selected(options, "buildImgFromGaussPyr"))
+            report(runKernel("buildImgFromGaussPyr", size, channels, options,
+                             [&]() { buildImgFromGaussPyr(gaussPyr.back(), levels, dst, size); }), results);
+        if(selected(options, "addGaussDelta"))
+            report(runKernel("addGaussDelta", size, channels, options,
+                             [&]() { addGaussDelta(gaussPyr.back(), levels, frame8u, dst, scratch); }), results);
+    }
+
+    if(selected(options, "buildLaplacePyrFromImg"))
+        report(runKernel("buildLaplacePyrFromImg", size, channels, options,
+                         [&]() { buildLaplacePyrFromImg(frame, levels, pyr); }), results);
+
+    if(selected(options, "buildImgFromLaplacePyr")) {
+        vector<cv::Mat> laplacePyr;
+        buildLaplacePyrFromImg(frame, levels, laplacePyr);
+        report(runKernel("buildImgFromLaplacePyr", size, channels, options,
+                         [&]() { buildImgFromLaplacePyr(laplacePyr, levels, dst); }), results);
+    }
+
+    // Persistent pyramid used by laplaceMagnify
+    if(selected(options, "LaplacePyramid::build") || selected(options, "LaplacePyramid::collapse")) {
+        LaplacePyramid laplace;
+        laplace.build(frame, levels);
+        if(selected(options, "LaplacePyramid::build"))
+            report(runKernel("LaplacePyramid::build", size, channels, options,
+                             [&]() { laplace.build(frame, levels); }), results);
+        if(selected(options, "LaplacePyramid::collapse"))
+            report(runKernel("LaplacePyramid::collapse", size, channels, options,
+                             [&]() { laplace.collapse(dst); }), results);
+    }
+
+    // Only defined for single channel images
+    if(channels == 1 && selected(options, "buildWaveletPyrFromImg")) {
+        vector< vector<cv::Mat> > waveletPyr;
+        report(runKernel("buildWaveletPyrFromImg", size, channels, options,
+                         [&]() { buildWaveletPyrFromImg(frame, levels, waveletPyr); }), results);
+    }
+}
+
+static void benchTemporal(const cv::Size &size, int channels, int levels, const BenchOptions &options,
+                          std::vector<BenchResult> &results)
+{
+    const cv::Mat frame = syntheticFrame(size, channels, 0);
+
+    // Applied to every Laplace level of the same size in laplaceMagnify
+    if(selected(options, "iirFilter")) {
+        cv::Mat lowpassHi = frame.clone();
+        cv::Mat lowpassLo = frame.clone();
+        cv::Mat dst;
+        const cv::Mat next = syntheticFrame(size, channels, 1);
+        report(runKernel("iirFilter", size, channels, options,
+                         [&]() { iirFilter(next, dst, lowpassHi, lowpassLo,
+                                           DEFAULT_MM_COLOW/100.0, DEFAULT_MM_COHIGH/100.0); }), results);
+    }
+
+    if(!selected(options, "img2tempMat") && !selected(options, "TemporalRingBuffer::push") &&
+       !selected(options, "idealFilter") && !selected(options, "SlidingDftBandpass::slide") &&
+       !selected(options, "ButterworthBandpass::filter"))
+        return;
+
+    // colorMagnify works on the coarsest Gauss level over a window of ~2 seconds
+    vector<cv::Mat> pyr;
+    buildGaussPyrFromImg(frame, levels, pyr);
+    const cv::Mat coarse = pyr.at(levels-1);
+
+    // Causal variant without a window, the cost of one frame
+    if(selected(options, "ButterworthBandpass::filter")) {
+        ButterworthBandpass bandpass;
+        cv::Mat filtered;
+        bandpass.filter(coarse, filtered, DEFAULT_CM_COLOW, DEFAULT_CM_COHIGH, options.framerate);
+        const cv::Mat next = coarse + cv::Scalar::all(1);
+        report(runKernel("ButterworthBandpass::filter", size, channels, options,
+                         [&]() { bandpass.filter(next, filtered, DEFAULT_CM_COLOW, DEFAULT_CM_COHIGH,
+                                                 options.framerate); }), results);
+    }
+
+    ImageProcessingFlags flags;
+    ImageProcessingSettings settings;
+    std::vector<cv::Mat> buffer;
+    int frameNum = 0;
+    Magnificator magnificator(&buffer, &flags, &settings, &frameNum);
+    const int window = magnificator.getOptimalBufferSize(static_cast<int>(options.framerate));
+
+    cv::Mat tempMat;
+    TemporalRingBuffer ring;
+    for(int i = 0; i < window; ++i) {
+        img2tempMat(coarse, tempMat, window);
+        ring.push(coarse, window);
+    }
+
+    // Former and current way of keeping the window
+    if(selected(options, "img2tempMat"))
+        report(runKernel("img2tempMat", size, channels, options,
+                         [&]() { img2tempMat(coarse, tempMat, window); }), results);
+    cv::Mat leaving;
+    if(selected(options, "TemporalRingBuffer::push"))
+        report(runKernel("TemporalRingBuffer::push", size, channels, options,
+                         [&]() { ring.push(coarse, window, &leaving); }), results);
+
+    // Random content, so the DFT doesn't run on a constant signal
+    cv::Mat stored = ring.stored();
+    cv::randu(stored, cv::Scalar::all(0), cv::Scalar::all(1));
+
+    if(selected(options, "idealFilter")) {
+        TemporalRingBuffer filtered;
+        IdealFilterPlan plan;
+        report(runKernel("idealFilter", size, channels, options,
+                         [&]() { idealFilter(ring, filtered, DEFAULT_CM_COLOW, DEFAULT_CM_COHIGH,
+                                             options.framerate, plan); }), results);
+    }
+
+    // Streaming replacement of idealFilter once the window is full, the window itself stays the same
+    if(selected(options, "SlidingDftBandpass::slide")) {
+        SlidingDftBandpass bandpass;
+        bandpass.init(ring, DEFAULT_CM_COLOW, DEFAULT_CM_COHIGH, options.framerate);
+        ring.frame(0).copyTo(leaving);
+        cv::Mat filtered;
+        report(runKernel("SlidingDftBandpass::slide", size, channels, options,
+                         [&]() {
+                             bandpass.slide(ring, leaving);
+                             bandpass.filteredFrame(window-1, filtered);
+                         }), results);
+    }
+}
+
+///////////////////////////////
+///Checks ////////////////////
+//////////////////////////////
+// Largest difference of SlidingDftBandpass::bandpassFrame to idealBandpass over the same window, relative to
+// the largest idealBandpass output, checked after init and after every slide across 2 recomputations.
+// Also prints the largest difference of the normalized zero level to the one of idealFilter.
+static bool checkSlidingDft(const cv::Size &size, int channels, int levels, int window, const BenchOptions &options)
+{
+    const cv::Mat frame = syntheticFrame(size, channels, 0);
+    vector<cv::Mat> pyr;
+    buildGaussPyrFromImg(frame, levels, pyr);
+    cv::Mat coarse = pyr.at(levels-1).clone();
+
+    TemporalRingBuffer ring;
+    cv::Mat leaving;
+    for(int i = 0; i < window; ++i) {
+        cv::randu(coarse, cv::Scalar::all(0), cv::Scalar::all(1));
+        ring.push(coarse, window);
+    }
+    SlidingDftBandpass bandpass;
+    bandpass.init(ring, DEFAULT_CM_COLOW, DEFAULT_CM_COHIGH, options.framerate);
+
+    const int seriesLength = ring.frame(0).cols * channels;
+    IdealFilterPlan plan;
+    cv::Mat frames(window, seriesLength, CV_32F);
+    cv::Mat series, reference, row;
+    double maxError = 0, maxZeroDrift = 0;
+
+    for(int slide = 0; slide <= 2*window; ++slide) {
+        if(slide > 0) {
+            cv::randu(coarse, cv::Scalar::all(0), cv::Scalar::all(1));
+            ring.push(coarse, window, &leaving);
+            bandpass.slide(ring, leaving);
+        }
+
+        // Oldest frame in column 0, like the temporal matrix of idealFilter
+        for(int n = 0; n < window; ++n)
+            ring.frame(n).reshape(1).copyTo(frames.row(n));
+        cv::transpose(frames, series);
+        idealBandpass(series, reference, DEFAULT_CM_COLOW, DEFAULT_CM_COHIGH, options.framerate, plan);
+
+        double minVal, maxVal;
+        cv::minMaxLoc(reference, &minVal, &maxVal);
+        const double scale = std::max(std::abs(minVal), std::abs(maxVal));
+        for(int position = 0; position < window; ++position) {
+            bandpass.bandpassFrame(position, row);
+            const double error = cv::norm(row.reshape(1), reference.col(position).t(), cv::NORM_INF);
+            maxError = std::max(maxError, scale > 0 ? error/scale : error);
+        }
+
+        // Newest frame, like SlidingDftBandpass::slide is timed
+        bandpass.filteredFrame(window-1, row);
+        const double zeroLevel = (maxVal > minVal) ? -minVal/(maxVal-minVal) : 0;
+        maxZeroDrift = std::max(maxZeroDrift, std::abs(bandpass.zeroLevel() - zeroLevel));
+    }
+
+    const bool ok = (maxError < 1e-4);
+    printf("%-36s %5dx%-5d %-5s %12.3g %12.3g  %s\n", "SlidingDftBandpass", size.width, size.height,
+           channels == 1 ? "gray" : "color", maxError, maxZeroDrift, ok ? "ok" : "FAILED");
+    fflush(stdout);
+    return ok;
+}
+
+///////////////////////////////
+///Riesz /////////////////////
+//////////////////////////////
+// The Riesz path only processes the luma channel, so it's measured on grayscale frames only
+static void benchRiesz(const cv::Size &size, int levels, const BenchOptions &options,
+                       std::vector<BenchResult> &results)
+{
+    cv::Mat prevFrame = syntheticFrame(size, 1, 0);
+    cv::Mat curFrame = syntheticFrame(size, 1, 1);
+
+    RieszPyramid oldPyr, curPyr;
+    oldPyr.init(prevFrame, levels);
+    curPyr.init(curFrame, levels);
+    curPyr.unwrapOrientPhase(oldPyr);
+
+    RieszTemporalFilter loCutoff(DEFAULT_PB_COLOW, options.framerate);
+    RieszTemporalFilter hiCutoff(DEFAULT_PB_COHIGH, options.framerate);
+    loCutoff.computeCoefficients();
+    hiCutoff.computeCoefficients();
+
+    // Same loop as Magnificator::rieszMagnify
+    auto passAll = [&]() {
+        for (int lvl = 0; lvl < curPyr.numLevels-1; ++lvl) {
+            loCutoff.pass(curPyr.pyrLevels[lvl].itsImagPass,
+                          curPyr.pyrLevels[lvl].itsPhase,
+                          oldPyr.pyrLevels[lvl].itsPhase);
+            hiCutoff.pass(curPyr.pyrLevels[lvl].itsRealPass,
+                          curPyr.pyrLevels[lvl].itsPhase,
+                          oldPyr.pyrLevels[lvl].itsPhase);
+        }
+    };
+    passAll();
+
+    if(selected(options, "RieszPyramid::buildPyramid"))
+        report(runKernel("RieszPyramid::buildPyramid", size, 1, options,
+                         [&]() { curPyr.buildPyramid(curFrame); }), results);
+
+    if(selected(options, "RieszPyramid::unwrapOrientPhase"))
+        report(runKernel("RieszPyramid::unwrapOrientPhase", size, 1, options,
+                         [&]() { curPyr.unwrapOrientPhase(oldPyr); }), results);
+
+    if(selected(options, "RieszTemporalFilter::pass"))
+        report(runKernel("RieszTemporalFilter::pass", size, 1, options, passAll), results);
+
+    // amplify writes itsMagnified and keeps itsLp, so every run sees the same input
+    if(selected(options, "RieszPyramid::amplify"))
+        report(runKernel("RieszPyramid::amplify", size, 1, options,
+                         [&]() { curPyr.amplify(DEFAULT_PB_AMPLIFICATION, DEFAULT_PB_COWAVELENGTH*M_PI/100.0); }),
+               results);
+
+    // Phases like the ones amplify takes the cosine and sine of, both accuracies
+    if(selected(options, "RieszPyramidLevel::cosSinX (fast)") ||
+       selected(options, "RieszPyramidLevel::cosSinX (precise)")) {
+        cv::Mat phases(size, CV_32F);
+        cv::randu(phases, cv::Scalar::all(0), cv::Scalar::all(M_PI));
+        CompExpMat cosSin;
+        if(selected(options, "RieszPyramidLevel::cosSinX (fast)"))
+            report(runKernel("RieszPyramidLevel::cosSinX (fast)", size, 1, options,
+                             [&]() { RieszPyramidLevel::cosSinX(phases, cosSin, TRANSCENDENTAL_FAST); }), results);
+        if(selected(options, "RieszPyramidLevel::cosSinX (precise)"))
+            report(runKernel("RieszPyramidLevel::cosSinX (precise)", size, 1, options,
+                             [&]() { RieszPyramidLevel::cosSinX(phases, cosSin, TRANSCENDENTAL_PRECISE); }), results);
+    }
+
+    if(selected(options, "RieszPyramid::collapsePyramid")) {
+        cv::Mat collapsed;
+        report(runKernel("RieszPyramid::collapsePyramid", size, 1, options,
+                         [&]() { collapsed = curPyr.collapsePyramid(); }), results);
+    }
+
+    // Laplacian levels instead of the 9x9 filters (ImageProcessingFlags::rieszFastOn)
+    RieszPyramid fastPyr;
+    fastPyr.init(curFrame, levels, true);
+    if(selected(options, "RieszPyramid::buildPyramid (fast)"))
+        report(runKernel("RieszPyramid::buildPyramid (fast)", size, 1, options,
+                         [&]() { fastPyr.buildPyramid(curFrame); }), results);
+
+    if(selected(options, "RieszPyramid::collapsePyramid (fast)")) {
+        cv::Mat collapsed;
+        report(runKernel("RieszPyramid::collapsePyramid (fast)", size, 1, options,
+                         [&]() { collapsed = fastPyr.collapsePyramid(); }), results);
+    }
+}
+
+///////////////////////////////
+///Breath extraction /////////
+//////////////////////////////
+static void benchBreath(const cv::Size &size, const BenchOptions &options, std::vector<BenchResult> &results)
+{
+    // Thresholded difference of two shifted frames, noisy like the mask laplaceMagnify passes
+    cv::Mat diff, mask;
+    cv::absdiff(syntheticFrame(size, 1, 0), syntheticFrame(size, 1, 1), diff);
+    diff.convertTo(mask, CV_8UC1, 255.0);
+    cv::threshold(mask, mask, 20, 255, cv::THRESH_BINARY_INV);
+
+    BreathExtractor extractor;
+    if(selected(options, "BreathExtractor::contours"))
+        report(runKernel("BreathExtractor::contours", size, 1, options,
+                         [&]() { extractor.extract(mask, BREATH_CONTOURS); }), results);
+    if(selected(options, "BreathExtractor::components"))
+        report(runKernel("BreathExtractor::components", size, 1, options,
+                         [&]() { extractor.extract(mask, BREATH_COMPONENTS); }), results);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    options.minTime = 0.5;
+    options.levels = DEFAULT_LAP_MAG_LEVELS;
+    options.framerate = 30;
+    parseSizes("640x480,1280x720,1920x1080,3840x2160", options.sizes);
+    std::string csvPath;
+    bool check = false;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if(arg == "--check")
+            check = true;
+        else if(i+1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        else if(arg == "--sizes") {
+            if(!parseSizes(argv[++i], options.sizes)) {
+                std::cerr << "Sizes have to be given as WxH,WxH,..." << std::endl;
+                return 1;
+            }
+        }
+        else if(arg == "--filter")
+            options.filter = argv[++i];
+        else if(arg == "--min-time")
+            options.minTime = atof(argv[++i]);
+        else if(arg == "--levels")
+            options.levels = atoi(argv[++i]);
+        else if(arg == "--fps")
+            options.framerate = atof(argv[++i]);
+        else if(arg == "--csv")
+            csvPath = argv[++i];
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(options.framerate <= 0 || options.minTime < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Fixed seed, so every run sees the same frames
+    cv::theRNG().state = 0x12345678;
+
+    ImageProcessingFlags flags;
+    ImageProcessingSettings settings;
+    std::vector<cv::Mat> buffer;
+    int frameNum = 0;
+    Magnificator magnificator(&buffer, &flags, &settings, &frameNum);
+
+    if(check) {
+        const int window = magnificator.getOptimalBufferSize(static_cast<int>(options.framerate));
+        printf("%-36s %11s %-5s %12s %12s\n", "check", "size", "type", "rel. error", "zero drift");
+        bool ok = true;
+        for(size_t s = 0; s < options.sizes.size(); ++s) {
+            const cv::Size size = options.sizes[s];
+            const int levels = std::max(1, std::min(options.levels, magnificator.calculateMaxLevels(size)));
+            for(int channels = 1; channels <= 3; channels += 2)
+                ok = checkSlidingDft(size, channels, levels, window, options) && ok;
+        }
+        return ok ? 0 : 1;
+    }
+
+    printf("%-36s %11s %-5s %8s %12s %12s\n", "kernel", "size", "type", "runs", "median [ms]", "min [ms]");
+    std::vector<BenchResult> results;
+
+    for(size_t s = 0; s < options.sizes.size(); ++s) {
+        const cv::Size size = options.sizes[s];
+        const int levels = std::max(1, std::min(options.levels, magnificator.calculateMaxLevels(size)));
+
+        for(int channels = 1; channels <= 3; channels += 2) {
+            benchPyramids(size, channels, levels, options, results);
+            benchTemporal(size, channels, levels, options, results);
+        }
+        // The Riesz pyramid needs at least one level besides the lowpass residual
+        benchRiesz(size, std::max(2, levels), options, results);
+        benchBreath(size, options, results);
+    }
+
+    if(!csvPath.empty()) {
+        std::ofstream csv(csvPath.c_str(), std::ios::out | std::ios::trunc);
+        if(!csv.is_open()) {
+            std::cerr << "Could not open " << csvPath << " for writing" << std::endl;
+            return 1;
+        }
+        csv << "kernel,width,height,channels,runs,median_ms,min_ms\n";
+        for(size_t i = 0; i < results.size(); ++i)
+            csv << results[i].kernel << "," << results[i].size.width << "," << results[i].size.height << ","
+                << results[i].channels << "," << results[i].iterations << ","
+                << results[i].medianMs << "," << results[i].minMs << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,389 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->CliMain.cpp                                        */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+// Headless front end for the Magnificator. Drives the same processing buffer protocol
+// as SavingThread, but without any Qt widgets, event loop or QImage conversion, so
+// recordings can be batch processed on machines without a display.
+
+// C++
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+// OpenCV
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/videoio.hpp>
+// Local
+#include "main/magnification/Magnificator.h"
+#include "main/other/Config.h"
+#include "main/other/Structures.h"
+
+enum CliMode { CLI_COLOR = 1, CLI_LAPLACE = 2, CLI_RIESZ = 3 };
+
+static void printUsage(const char *name)
+{
+    std::cerr
+        << "Usage: " << name << " --input <file|camera index> --mode <laplace|color|riesz> [options]\n"
+        << "\n"
+        << "Options (values are written to ImageProcessingSettings as they are, defaults follow Config.h):\n"
+        << "  --output <file>          Magnified video to write (omit to only analyse)\n"
+        << "  --csv <file>             Write <frame>,<breath value> for every processed frame\n"
+        << "  --rate                   Color only: estimate the dominant rate per minute, adds\n"
+        << "                           <rate>,<confidence> to every CSV line\n"
+        << "  --amplification <val>\n"
+        << "  --wavelength <val>       Cutoff wavelength (coWavelength)\n"
+        << "  --low <val>              Lower cutoff (coLow)\n"
+        << "  --high <val>             Upper cutoff (coHigh)\n"
+        << "  --chrom <val>            Chrominance attenuation (chromAttenuation)\n"
+        << "  --levels <n>             Pyramid levels, clamped to the maximum for the frame size\n"
+        << "  --decimate <n>           Filter the average of every n frames at framerate/n (decimation)\n"
+        << "  --fps <val>              Override the framerate of the input\n"
+        << "  --roi <x,y,w,h>          Only magnify this region of interest\n"
+        << "  --frames <n>             Stop after n written frames\n"
+        << "  --codec <FOURCC>         Codec of the output file (default MJPG)\n"
+        << "  --grayscale              Process grayscale images\n"
+        << "  --contours               Write the breath contours instead of the magnified image\n"
+        << "  --breath-only            Laplace only: compute the breath value without any image (no --output)\n"
+        << "  --causal                 Color only: causal Butterworth bandpass instead of the ideal filter\n"
+        << "  --fast-riesz             Riesz only: Laplacian pyramid levels instead of the 9x9 filters\n"
+        << "  --breath <method>        Breath regions: contours (default) or components\n";
+}
+
+static bool isNumber(const std::string &s)
+{
+    if(s.empty())
+        return false;
+    for(size_t i = 0; i < s.size(); ++i)
+        if(!isdigit(static_cast<unsigned char>(s[i])))
+            return false;
+    return true;
+}
+
+// Mirror MagnifyOptions::reset() followed by updateSettingsFromOptionsTab()
+static void applyDefaults(int mode, ImageProcessingSettings &settings)
+{
+    switch(mode) {
+    case CLI_COLOR:
+        settings.levels = DEFAULT_COL_MAG_LEVELS;
+        settings.amplification = DEFAULT_CM_AMPLIFICATION;
+        settings.coWavelength = DEFAULT_CM_COWAVELENGTH*10.0;
+        settings.coLow = DEFAULT_CM_COLOW;
+        settings.coHigh = DEFAULT_CM_COHIGH;
+        settings.chromAttenuation = DEFAULT_CM_CHROMATTENUATION/100.0;
+        break;
+    case CLI_LAPLACE:
+        settings.levels = DEFAULT_LAP_MAG_LEVELS;
+        settings.amplification = DEFAULT_MM_AMPLIFICATION;
+        settings.coWavelength = DEFAULT_MM_COWAVELENGTH*10.0;
+        settings.coLow = DEFAULT_MM_COLOW/100.0;
+        settings.coHigh = DEFAULT_MM_COHIGH/100.0;
+        settings.chromAttenuation = DEFAULT_MM_CHROMATTENUATION/100.0;
+        break;
+    case CLI_RIESZ:
+        settings.amplification = DEFAULT_PB_AMPLIFICATION;
+        settings.coWavelength = DEFAULT_PB_COWAVELENGTH;
+        settings.coLow = DEFAULT_PB_COLOW;
+        settings.coHigh = DEFAULT_PB_COHIGH;
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string input, output, csvPath, modeName;
+    std::string codecName = "MJPG";
+    std::string roiArg;
+    std::string breathName = "contours";
+    int mode = 0;
+    int maxFrames = -1;
+    double fps = -1;
+    bool grayscale = false;
+    bool contours = false;
+    bool breathOnly = false;
+    bool causal = false;
+    bool fastRiesz = false;
+    bool rate = false;
+
+    // Values given on the command line, applied after the defaults of the chosen mode
+    std::vector< std::pair<std::string, double> > overrides;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = (i+1 < argc);
+
+        if(arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if(arg == "--grayscale")
+            grayscale = true;
+        else if(arg == "--contours")
+            contours = true;
+        else if(arg == "--breath-only")
+            breathOnly = true;
+        else if(arg == "--causal")
+            causal = true;
+        else if(arg == "--fast-riesz")
+            fastRiesz = true;
+        else if(arg == "--rate")
+            rate = true;
+        else if(!hasValue) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        else if(arg == "--input")
+            input = argv[++i];
+        else if(arg == "--output")
+            output = argv[++i];
+        else if(arg == "--csv")
+            csvPath = argv[++i];
+        else if(arg == "--mode")
+            modeName = argv[++i];
+        else if(arg == "--breath")
+            breathName = argv[++i];
+        else if(arg == "--codec")
+            codecName = argv[++i];
+        else if(arg == "--roi")
+            roiArg = argv[++i];
+        else if(arg == "--frames")
+            maxFrames = atoi(argv[++i]);
+        else if(arg == "--fps")
+            fps = atof(argv[++i]);
+        else if(arg == "--amplification" || arg == "--wavelength" || arg == "--low" ||
+                arg == "--high" || arg == "--chrom" || arg == "--levels" || arg == "--decimate")
+            overrides.push_back(std::make_pair(arg, atof(argv[++i])));
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(modeName == "color")
+        mode = CLI_COLOR;
+    else if(modeName == "laplace")
+        mode = CLI_LAPLACE;
+    else if(modeName == "riesz")
+        mode = CLI_RIESZ;
+
+    if(input.empty() || mode == 0 || codecName.size() != 4 ||
+       (breathName != "contours" && breathName != "components") ||
+       (breathOnly && (mode != CLI_LAPLACE || !output.empty())) ||
+       (causal && mode != CLI_COLOR) || (fastRiesz && mode != CLI_RIESZ) || (rate && (mode != CLI_COLOR || causal))) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ///////////////////////////////////
+    /////////// Capture //////////////
+    /////////////////////////////////
+    cv::VideoCapture cap;
+    bool isCamera = isNumber(input);
+    if(isCamera)
+        cap.open(atoi(input.c_str()));
+    else
+        cap.open(input);
+
+    if(!cap.isOpened()) {
+        std::cerr << "Could not open " << input << std::endl;
+        return 1;
+    }
+
+    // OpenCV can't read all mp4s properly, fps is often false
+    if(fps <= 0)
+        fps = cap.get(cv::CAP_PROP_FPS);
+    if(fps <= 0 || !std::isfinite(fps))
+        fps = 30;
+
+    int frameWidth = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
+    int frameHeight = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+    cv::Rect roi(0, 0, frameWidth, frameHeight);
+    if(!roiArg.empty()) {
+        if(sscanf(roiArg.c_str(), "%d,%d,%d,%d", &roi.x, &roi.y, &roi.width, &roi.height) != 4) {
+            std::cerr << "ROI has to be given as x,y,w,h" << std::endl;
+            return 1;
+        }
+        roi &= cv::Rect(0, 0, frameWidth, frameHeight);
+    }
+    if(roi.area() <= 0) {
+        std::cerr << "Empty region of interest" << std::endl;
+        return 1;
+    }
+
+    ///////////////////////////////////
+    /////////// Settings /////////////
+    /////////////////////////////////
+    ImageProcessingFlags imgProcFlags;
+    ImageProcessingSettings imgProcSettings;
+    std::vector<cv::Mat> processingBuffer;
+    int frameNum = 0;
+    Magnificator magnificator(&processingBuffer, &imgProcFlags, &imgProcSettings, &frameNum);
+
+    imgProcFlags.grayscaleOn = grayscale;
+    imgProcFlags.colorMagnifyOn = (mode == CLI_COLOR);
+    imgProcFlags.laplaceMagnifyOn = (mode == CLI_LAPLACE);
+    imgProcFlags.rieszMagnifyOn = (mode == CLI_RIESZ);
+    imgProcFlags.analysisOnlyOn = breathOnly;
+    imgProcFlags.colorIirOn = causal;
+    imgProcFlags.rieszFastOn = fastRiesz;
+
+    // Like MagnifyOptions::setMaxLevel, start with the highest level possible for the ROI
+    int maxLevels = magnificator.calculateMaxLevels(roi.size());
+    imgProcSettings.levels = maxLevels;
+    applyDefaults(mode, imgProcSettings);
+    for(size_t i = 0; i < overrides.size(); ++i) {
+        const std::string &key = overrides[i].first;
+        double val = overrides[i].second;
+        if(key == "--amplification")    imgProcSettings.amplification = val;
+        else if(key == "--wavelength")  imgProcSettings.coWavelength = val;
+        else if(key == "--low")         imgProcSettings.coLow = val;
+        else if(key == "--high")        imgProcSettings.coHigh = val;
+        else if(key == "--chrom")       imgProcSettings.chromAttenuation = val;
+        else if(key == "--levels")      imgProcSettings.levels = static_cast<int>(val);
+        else if(key == "--decimate")    imgProcSettings.decimation = std::max(1, static_cast<int>(val));
+    }
+    imgProcSettings.levels = std::max(1, std::min(imgProcSettings.levels, maxLevels));
+    imgProcSettings.framerate = fps;
+    imgProcSettings.frameWidth = roi.width;
+    imgProcSettings.frameHeight = roi.height;
+    imgProcSettings.MagnifiedOrContours = contours;
+    imgProcSettings.breathMethod = (breathName == "components") ? BREATH_COMPONENTS : BREATH_CONTOURS;
+    imgProcSettings.rateEstimation = rate;
+    // CSV is written here, not by the Magnificator's caller threads
+    imgProcSettings.CSV = false;
+
+    // Same buffer lengths as SavingThread::saveFile
+    int processingBufferLength = 2;
+    if(imgProcFlags.colorMagnifyOn && !imgProcFlags.colorIirOn)
+        processingBufferLength = magnificator.getOptimalBufferSize(fps);
+
+    ///////////////////////////////////
+    /////////// Output ///////////////
+    /////////////////////////////////
+    cv::VideoWriter out;
+    if(!output.empty()) {
+        int codec = cv::VideoWriter::fourcc(codecName[0], codecName[1], codecName[2], codecName[3]);
+        if(!out.open(output, codec, fps, roi.size(), !grayscale)) {
+            std::cerr << "Could not open " << output << " for writing" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream csv;
+    if(!csvPath.empty()) {
+        csv.open(csvPath.c_str(), std::ios::out | std::ios::trunc);
+        if(!csv.is_open()) {
+            std::cerr << "Could not open " << csvPath << " for writing" << std::endl;
+            return 1;
+        }
+    }
+
+    ///////////////////////////////////
+    /////////// Processing ///////////
+    /////////////////////////////////
+    cv::Mat grabbedFrame, currentFrame;
+    int framesWritten = 0;
+    bool endOfInput = false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    auto magnify = [&]() {
+        if(imgProcFlags.colorMagnifyOn)
+            magnificator.colorMagnify();
+        else if(imgProcFlags.laplaceMagnifyOn)
+            magnificator.laplaceMagnify();
+        else
+            magnificator.rieszMagnify();
+    };
+    auto writeFrame = [&]() {
+        cv::Mat processedFrame = magnificator.getFrameFirst();
+        frameNum++;
+
+        if(out.isOpened())
+            out.write(processedFrame);
+        if(csv.is_open()) {
+            csv << frameNum << "," << magnificator.breathMeasureOutput;
+            if(rate)
+                csv << "," << magnificator.rateMeasureOutput << "," << magnificator.rateConfidenceOutput;
+            csv << "\n";
+        }
+        framesWritten++;
+    };
+    auto belowLimit = [&]() { return maxFrames < 0 || framesWritten < maxFrames; };
+
+    while(!endOfInput && belowLimit()) {
+        // Switch to process images on the fly once the first color window was magnified
+        if(imgProcFlags.colorMagnifyOn && processingBufferLength > 2 && framesWritten == 1)
+            processingBufferLength = 2;
+
+        // Fill buffer
+        for(int i = processingBuffer.size(); i < processingBufferLength; i++) {
+            if(!cap.read(grabbedFrame)) {
+                endOfInput = true;
+                break;
+            }
+            currentFrame = cv::Mat(grabbedFrame, roi).clone();
+            if(imgProcFlags.grayscaleOn && (currentFrame.channels() == 3 || currentFrame.channels() == 4))
+                cvtColor(currentFrame, currentFrame, cv::COLOR_BGR2GRAY, 1);
+            processingBuffer.push_back(currentFrame);
+        }
+        if(endOfInput)
+            break;
+
+        magnify();
+        if(magnificator.hasFrame())
+            writeFrame();
+    }
+
+    // Like SavingThread once the whole video was captured, magnify what is still buffered
+    // and write every frame the magnificator holds
+    if(endOfInput) {
+        // Laplace and Riesz magnify a frame only once the next one arrived, so the last one is repeated.
+        // Before the first frame was written it is magnified right away, the repetition would reset the filters.
+        if(!imgProcFlags.colorMagnifyOn && framesWritten > 0 && !processingBuffer.empty())
+            processingBuffer.push_back(processingBuffer.back());
+        // Color takes new frames from the buffer only after the magnified ones were handed out
+        do {
+            magnify();
+            while(magnificator.hasFrame() && belowLimit())
+                writeFrame();
+        } while(imgProcFlags.colorMagnifyOn && !processingBuffer.empty() && belowLimit());
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Processed " << framesWritten << " frames (" << roi.width << "x" << roi.height
+              << ", " << imgProcSettings.levels << " levels) in " << seconds << " s, "
+              << (seconds > 0 ? framesWritten/seconds : 0) << " fps" << std::endl;
+
+    cap.release();
+    if(out.isOpened())
+        out.release();
+
+    return 0;
+}
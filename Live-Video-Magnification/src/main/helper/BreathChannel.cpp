@@ -0,0 +1,278 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->BreathChannel.cpp                                  */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#include "main/helper/BreathChannel.h"
+// C++
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+// Platform
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(BreathSample) == 32, "BreathSample layout is shared with other processes");
+static_assert(offsetof(BreathChannelLayout, magic) == 16, "Legacy value has to stay in the first 16 bytes");
+static_assert(offsetof(BreathChannelLayout, sequence) == 32, "Shared layout must not depend on the compiler");
+
+// Serializes writers of this process, the seqlock only supports one writer
+static std::mutex publishMutex;
+
+BreathChannel::BreathChannel() :
+    layout(0),
+    writable(false),
+    source(BREATH_SOURCE_VIDEO)
+{
+#ifdef _WIN32
+    hMapFile = NULL;
+#else
+    fd = -1;
+#endif
+}
+
+BreathChannel::~BreathChannel()
+{
+    close();
+}
+
+bool BreathChannel::create(int32_t source)
+{
+    if(!map(true))
+        return false;
+    this->source = source;
+
+    std::lock_guard<std::mutex> locker(publishMutex);
+    if(layout->magic == BREATH_CHANNEL_MAGIC && layout->version == BREATH_CHANNEL_VERSION &&
+       layout->capacity == BREATH_CHANNEL_CAPACITY && layout->sampleSize == sizeof(BreathSample)) {
+        // Already set up, other writers of this process keep their samples. Writers of this process can't be
+        // in the middle of a sample while publishMutex is held, an odd sequence was left by a dead writer
+        const uint64_t seq = layout->sequence.load(std::memory_order_relaxed);
+        if(seq & 1)
+            layout->sequence.store(seq + 1, std::memory_order_release);
+        return true;
+    }
+
+    // New segment or another layout: start with an empty ring
+    layout->sequence.store(layout->sequence.load(std::memory_order_relaxed) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    layout->legacyValue = 0;
+    std::memset(layout->legacyPadding, 0, sizeof(layout->legacyPadding));
+    layout->magic = BREATH_CHANNEL_MAGIC;
+    layout->version = BREATH_CHANNEL_VERSION;
+    layout->capacity = BREATH_CHANNEL_CAPACITY;
+    layout->sampleSize = sizeof(BreathSample);
+    std::memset(layout->samples, 0, sizeof(layout->samples));
+    layout->written.store(0, std::memory_order_relaxed);
+    layout->sequence.store(layout->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool BreathChannel::attach()
+{
+    if(!map(false))
+        return false;
+
+    if(layout->magic != BREATH_CHANNEL_MAGIC || layout->version != BREATH_CHANNEL_VERSION ||
+       layout->capacity != BREATH_CHANNEL_CAPACITY || layout->sampleSize != sizeof(BreathSample)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool BreathChannel::map(bool create)
+{
+    close();
+    const size_t size = sizeof(BreathChannelLayout);
+    void *view = 0;
+
+#ifdef _WIN32
+    if(create)
+        hMapFile = CreateFileMappingA(INVALID_HANDLE_VALUE,    // use paging file
+                                      NULL,                    // default security
+                                      PAGE_READWRITE,          // read/write access
+                                      0,                       // maximum object size (high-order DWORD)
+                                      (DWORD)size,             // maximum object size (low-order DWORD)
+                                      BREATH_CHANNEL_NAME);    // name of mapping object
+    else
+        hMapFile = OpenFileMappingA(FILE_MAP_READ, FALSE, BREATH_CHANNEL_NAME);
+
+    if(hMapFile == NULL)
+        return false;
+
+    view = MapViewOfFile((HANDLE)hMapFile, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+    if(view == NULL) {
+        CloseHandle((HANDLE)hMapFile);
+        hMapFile = NULL;
+        return false;
+    }
+#else
+    const char *name = "/" BREATH_CHANNEL_NAME;
+    fd = create ? shm_open(name, O_CREAT | O_RDWR, 0666)
+                : shm_open(name, O_RDONLY, 0);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (!create && (size_t)st.st_size < size) ||
+       (create && (size_t)st.st_size < size && ftruncate(fd, size) != 0)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    view = mmap(0, size, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    if(view == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+#endif
+
+    layout = static_cast<BreathChannelLayout*>(view);
+    writable = create;
+    return true;
+}
+
+void BreathChannel::close()
+{
+    if(!layout)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(layout);
+    CloseHandle((HANDLE)hMapFile);
+    hMapFile = NULL;
+#else
+    munmap(layout, sizeof(BreathChannelLayout));
+    ::close(fd);
+    fd = -1;
+#endif
+    layout = 0;
+    writable = false;
+}
+
+bool BreathChannel::isOpen()
+{
+    return layout != 0;
+}
+
+void BreathChannel::publish(int value, int64_t frameNumber, float rate, float rateConfidence)
+{
+    if(!layout || !writable)
+        return;
+
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> locker(publishMutex);
+    const uint64_t seq = layout->sequence.load(std::memory_order_relaxed);
+    const uint64_t n = layout->written.load(std::memory_order_relaxed);
+
+    // Odd sequence: readers retry until the sample is complete
+    layout->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    BreathSample &sample = layout->samples[n % BREATH_CHANNEL_CAPACITY];
+    sample.timestampNs = now;
+    sample.frameNumber = frameNumber;
+    sample.value = value;
+    sample.source = source;
+    sample.rate = rate;
+    sample.rateConfidence = rateConfidence;
+    layout->written.store(n + 1, std::memory_order_relaxed);
+    layout->legacyValue = value;
+
+    layout->sequence.store(seq + 2, std::memory_order_release);
+}
+
+bool BreathChannel::readLatest(BreathSample &sample)
+{
+    if(!layout)
+        return false;
+
+    for(int attempt = 0; attempt < BREATH_CHANNEL_READ_RETRIES; ++attempt) {
+        if(attempt > 0)
+            std::this_thread::yield();
+
+        const uint64_t seq = layout->sequence.load(std::memory_order_acquire);
+        if(seq & 1)
+            continue;
+
+        const uint64_t n = layout->written.load(std::memory_order_relaxed);
+        if(n > 0)
+            std::memcpy(&sample, &layout->samples[(n - 1) % BREATH_CHANNEL_CAPACITY], sizeof(BreathSample));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(layout->sequence.load(std::memory_order_relaxed) == seq)
+            return n > 0;
+    }
+    // Writer stuck (or dead) in the middle of a sample, the caller tries again later
+    return false;
+}
+
+size_t BreathChannel::readSince(uint64_t &cursor, std::vector<BreathSample> &samples)
+{
+    samples.clear();
+    if(!layout)
+        return 0;
+
+    BreathSample ring[BREATH_CHANNEL_CAPACITY];
+    uint64_t n = 0, first = 0;
+    bool consistent = false;
+
+    for(int attempt = 0; attempt < BREATH_CHANNEL_READ_RETRIES && !consistent; ++attempt) {
+        if(attempt > 0)
+            std::this_thread::yield();
+
+        const uint64_t seq = layout->sequence.load(std::memory_order_acquire);
+        if(seq & 1)
+            continue;
+
+        n = layout->written.load(std::memory_order_relaxed);
+        // A newer writer may have restarted the ring
+        first = (cursor > n) ? 0 : cursor;
+        if(n - first > BREATH_CHANNEL_CAPACITY)
+            first = n - BREATH_CHANNEL_CAPACITY;
+        for(uint64_t i = first; i < n; ++i)
+            std::memcpy(&ring[i - first], &layout->samples[i % BREATH_CHANNEL_CAPACITY], sizeof(BreathSample));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        consistent = (layout->sequence.load(std::memory_order_relaxed) == seq);
+    }
+    // Writer stuck (or dead) in the middle of a sample, the caller tries again later
+    if(!consistent)
+        return 0;
+
+    samples.assign(ring, ring + (n - first));
+    cursor = n;
+    return samples.size();
+}
@@ -0,0 +1,141 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->BreathChannel.h                                    */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#ifndef BREATHCHANNEL_H
+#define BREATHCHANNEL_H
+
+// C++
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+// Name of the shared memory segment, "/ReimaginingBreath" for shm_open
+#define BREATH_CHANNEL_NAME                 "ReimaginingBreath"
+// Number of samples kept in the ring
+#define BREATH_CHANNEL_CAPACITY             64
+#define BREATH_CHANNEL_MAGIC                0x52425248 // "HRBR" little endian
+#define BREATH_CHANNEL_VERSION              3
+// BreathSample::source of values computed from a video file instead of a camera
+#define BREATH_SOURCE_VIDEO                 -1
+// Attempts of a seqlock read before it gives up, e.g. because a writer died in the middle of a sample
+#define BREATH_CHANNEL_READ_RETRIES         1000
+
+/*!
+ * \brief The BreathSample struct One published breath value.
+ */
+struct BreathSample {
+    int64_t timestampNs;    // std::chrono::steady_clock, shared by all processes of a machine
+    int64_t frameNumber;    // Frame the value was computed for
+    int32_t value;          // Breath value, like written to the CSV
+    int32_t source;         // Camera device number, BREATH_SOURCE_VIDEO for the video player
+    float rate;             // Dominant rate per minute (ImageProcessingSettings::rateEstimation), else 0
+    float rateConfidence;   // Share of the rate's bin in the passband power, 0 without an estimate
+};
+
+/*!
+ * \brief The BreathChannelLayout struct Memory layout of the shared segment.
+ *  The first 16 bytes stay compatible with the former 256 byte segment: readers that decode
+ *  the first bytes as a little endian integer still get the newest value.
+ *  Everything after is guarded by a seqlock: the writer makes sequence odd, writes, then makes
+ *  it even again. A reader copies what it needs and retries if sequence was odd or changed meanwhile,
+ *  yielding between attempts and giving up after BREATH_CHANNEL_READ_RETRIES.
+ */
+struct BreathChannelLayout {
+    int32_t legacyValue;
+    int32_t legacyPadding[3];
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t sampleSize;
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> written;  // Number of samples ever published, newest is at (written-1) % capacity
+    BreathSample samples[BREATH_CHANNEL_CAPACITY];
+};
+
+/*!
+ * \brief The BreathChannel class Publishes breath values to other processes (e.g. the Python GUI)
+ *  through named shared memory. Uses CreateFileMapping on Windows and shm_open/mmap elsewhere.
+ *  Every thread of a process may publish through its own BreathChannel: their samples share one ring,
+ *  are serialized and told apart by BreathSample::source. Only one process may write at a time,
+ *  readers may poll at any rate.
+ */
+class BreathChannel
+{
+    public:
+        BreathChannel();
+        ~BreathChannel();
+        /*!
+         * \brief create Creates (or reuses) the segment for writing. The ring is only reset if the segment
+         *  has no valid layout yet, so samples of other writers are kept.
+         * \param source Written to BreathSample::source of every published sample.
+         * \return True if the segment is mapped.
+         */
+        bool create(int32_t source);
+        /*!
+         * \brief attach Maps an existing segment for reading.
+         * \return True if the segment exists and has a matching layout.
+         */
+        bool attach();
+        /*!
+         * \brief close Unmaps the segment. The segment itself is kept for other readers.
+         */
+        void close();
+        bool isOpen();
+        /*!
+         * \brief publish Appends a timestamped sample to the ring and updates the legacy value.
+         * \param value Breath value.
+         * \param frameNumber Frame the value belongs to.
+         * \param rate Dominant rate per minute, 0 if it isn't estimated.
+         * \param rateConfidence Confidence of rate, 0 if it isn't estimated.
+         */
+        void publish(int value, int64_t frameNumber, float rate, float rateConfidence);
+        /*!
+         * \brief readLatest Lock free read of the newest sample.
+         * \param sample Newest sample.
+         * \return False if nothing was published yet or the writer didn't finish a sample in time.
+         */
+        bool readLatest(BreathSample &sample);
+        /*!
+         * \brief readSince Lock free read of every sample published after cursor.
+         * \param cursor Number of samples already seen, updated to the number of samples published.
+         *  Samples that were overwritten in the ring before they were read are skipped.
+         * \param samples Receives the new samples, oldest first.
+         * \return Number of new samples. 0 with cursor unchanged if the writer didn't finish a sample in time.
+         */
+        size_t readSince(uint64_t &cursor, std::vector<BreathSample> &samples);
+
+    private:
+        BreathChannelLayout *layout;
+        bool writable;
+        int32_t source;
+#ifdef _WIN32
+        void *hMapFile;
+#else
+        int fd;
+#endif
+        bool map(bool create);
+};
+
+#endif // BREATHCHANNEL_H
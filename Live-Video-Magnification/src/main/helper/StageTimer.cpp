@@ -0,0 +1,139 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->StageTimer.cpp                                     */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#include "main/helper/StageTimer.h"
+// C++
+#include <algorithm>
+
+StageTimer::StageTimer()
+{
+    clear();
+}
+
+void StageTimer::begin()
+{
+    startTime = std::chrono::steady_clock::now();
+}
+
+void StageTimer::end(int stage)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(stage >= 0 && stage < STAGE_COUNT)
+        currentFrame[stage] = std::max(currentFrame[stage], 0LL) +
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - startTime).count();
+    startTime = now;
+}
+
+void StageTimer::finishFrame()
+{
+    for(int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if(currentFrame[stage] >= 0)
+            add(stage, currentFrame[stage]);
+        currentFrame[stage] = -1;
+    }
+}
+
+void StageTimer::add(int stage, long long ns)
+{
+    if(stage < 0 || stage >= STAGE_COUNT)
+        return;
+
+    std::vector<long long> &ring = durations[stage];
+    if(static_cast<int>(ring.size()) < STAGE_TIMING_WINDOW_LENGTH) {
+        ring.push_back(ns);
+    }
+    else {
+        ring[next[stage]] = ns;
+        next[stage] = (next[stage] + 1) % STAGE_TIMING_WINDOW_LENGTH;
+    }
+}
+
+void StageTimer::fillStatistics(ThreadStatisticsData &stats)
+{
+    std::vector<long long> sorted;
+
+    for(int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if(durations[stage].empty()) {
+            stats.stageP50[stage] = 0;
+            stats.stageP95[stage] = 0;
+            stats.stageP99[stage] = 0;
+            continue;
+        }
+
+        sorted = durations[stage];
+        std::sort(sorted.begin(), sorted.end());
+        const size_t last = sorted.size() - 1;
+        stats.stageP50[stage] = sorted[last * 50 / 100];
+        stats.stageP95[stage] = sorted[last * 95 / 100];
+        stats.stageP99[stage] = sorted[last * 99 / 100];
+    }
+}
+
+void StageTimer::clear()
+{
+    for(int stage = 0; stage < STAGE_COUNT; ++stage) {
+        durations[stage].clear();
+        durations[stage].reserve(STAGE_TIMING_WINDOW_LENGTH);
+        next[stage] = 0;
+        currentFrame[stage] = -1;
+    }
+    startTime = std::chrono::steady_clock::now();
+}
+
+const char *StageTimer::stageName(int stage)
+{
+    switch(stage) {
+        case STAGE_PYRAMID:             return "Pyramid";
+        case STAGE_TEMPORAL:            return "Temporal filter";
+        case STAGE_AMPLIFY:             return "Amplify";
+        case STAGE_COLLAPSE:            return "Collapse";
+        case STAGE_COLOR_CONVERSION:    return "Conversion";
+        case STAGE_BREATH:              return "Breath";
+        case STAGE_TO_QIMAGE:           return "To QImage";
+        default:                        return "";
+    }
+}
+
+QString StageTimer::formatStageTimings(const ThreadStatisticsData &stats)
+{
+    QString timings;
+    for(int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if(stats.stageP99[stage] == 0)
+            continue;
+        if(!timings.isEmpty())
+            timings += "\n";
+        timings += QString(stageName(stage)) + QString(": ") +
+                QString::number(stats.stageP50[stage]/1e6, 'f', 2) + QString("/") +
+                QString::number(stats.stageP95[stage]/1e6, 'f', 2) + QString("/") +
+                QString::number(stats.stageP99[stage]/1e6, 'f', 2) + QString(" ms");
+    }
+    // Dominant rate of color magnification, with the confidence in percent
+    if(stats.ratePerMinute > 0) {
+        if(!timings.isEmpty())
+            timings += "\n";
+        timings += QString("Rate: ") + QString::number(stats.ratePerMinute, 'f', 1) + QString("/min (") +
+                QString::number(stats.rateConfidence*100.0, 'f', 0) + QString("%)");
+    }
+    return timings;
+}
@@ -0,0 +1,94 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->StageTimer.h                                       */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+// Qt
+#include <QString>
+// C++
+#include <chrono>
+#include <vector>
+// Local
+#include "main/other/Config.h"
+#include "main/other/Structures.h"
+
+/*!
+ * \brief The StageTimer class Measures the duration of every PipelineStage with the steady clock
+ *  and keeps the last STAGE_TIMING_WINDOW_LENGTH durations of each stage to compute rolling percentiles.
+ */
+class StageTimer
+{
+    public:
+        StageTimer();
+        /*!
+         * \brief begin Starts the clock for the next stage.
+         */
+        void begin();
+        /*!
+         * \brief end Accounts the time since the last begin() or end() to a stage of the current frame
+         *  and restarts the clock, so consecutive stages can be timed with one begin() and several end() calls.
+         * \param stage PipelineStage the time is accounted to.
+         */
+        void end(int stage);
+        /*!
+         * \brief finishFrame Adds the accumulated time of every stage that ran in the current frame.
+         */
+        void finishFrame();
+        /*!
+         * \brief add Adds a duration that was measured elsewhere to a stage.
+         * \param stage PipelineStage the time is accounted to.
+         * \param ns Duration in nanoseconds.
+         */
+        void add(int stage, long long ns);
+        /*!
+         * \brief fillStatistics Writes p50/p95/p99 of every stage into the statistics.
+         * \param stats Statistics that are sent to the GUI.
+         */
+        void fillStatistics(ThreadStatisticsData &stats);
+        /*!
+         * \brief clear Forgets every measured duration.
+         */
+        void clear();
+        /*!
+         * \brief stageName Name of a PipelineStage to show in the GUI.
+         */
+        static const char *stageName(int stage);
+        /*!
+         * \brief formatStageTimings Text of the stage timings label: p50/p95/p99 of every stage that ran
+         *  and the dominant rate of color magnification, one per line.
+         * \param stats Statistics filled by fillStatistics.
+         */
+        static QString formatStageTimings(const ThreadStatisticsData &stats);
+
+    private:
+        std::chrono::steady_clock::time_point startTime;
+        // Time spent in every stage in the current frame, -1 if the stage did not run
+        long long currentFrame[STAGE_COUNT];
+        // Ring of durations for every stage, next is the position that is overwritten next
+        std::vector<long long> durations[STAGE_COUNT];
+        int next[STAGE_COUNT];
+};
+
+#endif // STAGETIMER_H
@@ -0,0 +1,118 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->BreathExtractor.cpp                                */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#include "main/magnification/BreathExtractor.h"
+#include "main/other/Config.h"
+#include "main/other/Structures.h"
+// C++
+#include <algorithm>
+
+BreathExtractor::BreathExtractor() :
+    method(BREATH_CONTOURS),
+    numSelected(0)
+{
+}
+
+bool BreathExtractor::largerRegion(const Region &a, const Region &b)
+{
+    if(a.area != b.area)
+        return a.area > b.area;
+    return a.index < b.index;
+}
+
+int BreathExtractor::meanY(const std::vector<cv::Point> &contour)
+{
+    int ySum = 0;
+    for(size_t i = 0; i < contour.size(); ++i)
+        ySum += contour[i].y;
+    return ySum / static_cast<int>(contour.size());
+}
+
+int BreathExtractor::extract(const cv::Mat &mask, int method)
+{
+    this->method = method;
+    regions.clear();
+
+    // Measure every region once
+    if(method == BREATH_COMPONENTS) {
+        const int numLabels = cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
+        // Label 0 is the background
+        for(int label = 1; label < numLabels; ++label) {
+            Region region = { static_cast<double>(stats.at<int>(label, cv::CC_STAT_AREA)), label };
+            regions.push_back(region);
+        }
+    }
+    else {
+        cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_TC89_L1);
+        for(size_t i = 0; i < contours.size(); ++i) {
+            Region region = { cv::contourArea(contours[i]), static_cast<int>(i) };
+            regions.push_back(region);
+        }
+    }
+
+    // Only the largest regions are ordered
+    const int numRegions = static_cast<int>(regions.size());
+    numSelected = std::min(numRegions, BREATH_NUM_REGIONS);
+    std::partial_sort(regions.begin(), regions.begin() + numSelected, regions.end(), largerRegion);
+
+    // Too few regions, likely not breathing
+    if(numRegions <= BREATH_MIN_REGIONS)
+        return 0;
+
+    // Average of the mean y of every selected region
+    int ySum = 0;
+    for(int i = 0; i < numSelected; ++i) {
+        if(method == BREATH_COMPONENTS)
+            ySum += static_cast<int>(centroids.at<double>(regions[i].index, 1));
+        else
+            ySum += meanY(contours[regions[i].index]);
+    }
+    return ySum / numSelected;
+}
+
+void BreathExtractor::draw(cv::Mat &dst) const
+{
+    if(method != BREATH_COMPONENTS) {
+        for(int i = 0; i < numSelected; ++i)
+            cv::drawContours(dst, contours, regions[i].index, cv::Scalar(0,255,0), 2, cv::LINE_AA);
+        return;
+    }
+
+    // Paint the pixels of the selected components
+    selectedLabel.assign(stats.rows, 0);
+    for(int i = 0; i < numSelected; ++i)
+        selectedLabel[regions[i].index] = 1;
+    for(int y = 0; y < labels.rows; ++y) {
+        const int *label = labels.ptr<int>(y);
+        cv::Vec3b *pixel = dst.ptr<cv::Vec3b>(y);
+        for(int x = 0; x < labels.cols; ++x)
+            if(selectedLabel[label[x]])
+                pixel[x] = cv::Vec3b(0, 255, 0);
+    }
+}
+
+int BreathExtractor::numRegions() const
+{
+    return static_cast<int>(regions.size());
+}
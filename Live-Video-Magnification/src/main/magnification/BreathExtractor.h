@@ -0,0 +1,88 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->BreathExtractor.h                                  */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#ifndef BREATHEXTRACTOR_H
+#define BREATHEXTRACTOR_H
+// OpenCV
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+// C++
+#include <vector>
+
+/*!
+ * \brief The BreathExtractor class Computes the breath value from a binary motion mask.
+ *  The mask is split into regions, the largest ones are selected and the breath value is the average
+ *  of their mean y coordinates. Every region is measured once, only the selected ones are ordered.
+ *  The scratch memory is kept between frames.
+ */
+class BreathExtractor
+{
+public:
+    BreathExtractor();
+    /*!
+     * \brief extract Finds the regions of a mask and computes the breath value.
+     * \param mask Binary 8bit image, regions are non zero.
+     * \param method BREATH_CONTOURS: outer contours, area by cv::contourArea, y by the mean of the
+     *  contour points. BREATH_COMPONENTS: 8-connected components, area and centroid y (first order
+     *  moments of the pixels) from cv::connectedComponentsWithStats.
+     * \return Breath value, 0 if there are too few regions to be breathing.
+     */
+    int extract(const cv::Mat &mask, int method);
+    /*!
+     * \brief draw Draws the selected regions of the last extract() in green.
+     * \param dst BGR 8bit image of the size of the mask.
+     */
+    void draw(cv::Mat &dst) const;
+    /*!
+     * \brief numRegions Number of regions found by the last extract(), selected or not.
+     */
+    int numRegions() const;
+
+private:
+    struct Region {
+        double area;
+        int index;  // Contour index or component label
+    };
+    // Larger area first, lower index for equal areas
+    static bool largerRegion(const Region &a, const Region &b);
+    /*!
+     * \brief meanY Average y of the contour points, truncated like the value always was.
+     */
+    static int meanY(const std::vector<cv::Point> &contour);
+
+    int method;
+    // Every region of the last mask, the first numSelected ones are the largest in descending order
+    std::vector<Region> regions;
+    int numSelected;
+    // BREATH_CONTOURS
+    std::vector<std::vector<cv::Point>> contours;
+    // BREATH_COMPONENTS
+    cv::Mat labels;
+    cv::Mat stats;
+    cv::Mat centroids;
+    // Lookup of the selected labels, only used by draw
+    mutable std::vector<unsigned char> selectedLabel;
+};
+
+#endif // BREATHEXTRACTOR_H
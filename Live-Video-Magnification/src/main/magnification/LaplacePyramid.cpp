@@ -0,0 +1,125 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->LaplacePyramid.cpp                                 */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#include "main/magnification/LaplacePyramid.h"
+// C++
+#include <algorithm>
+
+LaplacePyramid::LaplacePyramid() :
+    type(CV_32F)
+{
+}
+
+void LaplacePyramid::build(const cv::Mat &img, int numLevels, int firstLevel, int lastLevel)
+{
+    if(lastLevel < 0 || lastLevel > numLevels)
+        lastLevel = numLevels;
+    levels.resize(numLevels+1);
+    sizes.resize(numLevels+1);
+    down.resize(numLevels);
+    up.resize(numLevels);
+    type = img.type();
+
+    cv::Mat currentLevel = img;
+    sizes[0] = img.size();
+    for (int level = 0; level < numLevels; ++level) {
+        const cv::Size downSize((sizes[level].width+1)/2, (sizes[level].height+1)/2);
+        sizes[level+1] = downSize;
+        // Levels after lastLevel are neither computed nor needed to compute others
+        if(level > lastLevel) {
+            levels[level].release();
+            continue;
+        }
+
+        cv::pyrDown(currentLevel, down[level], downSize);
+        if(level >= firstLevel) {
+            cv::pyrUp(down[level], up[level], currentLevel.size());
+            cv::subtract(currentLevel, up[level], levels[level]);
+        }
+        else
+            levels[level].release();
+        currentLevel = down[level];
+    }
+
+    if(lastLevel == numLevels && firstLevel <= numLevels)
+        currentLevel.copyTo(levels[numLevels]);
+    else
+        levels[numLevels].release();
+}
+
+void LaplacePyramid::collapse(cv::Mat &dst, int firstLevel, int lastLevel)
+{
+    const int numLevels = this->numLevels();
+    if(lastLevel < 0 || lastLevel > numLevels)
+        lastLevel = numLevels;
+    firstLevel = std::max(firstLevel, 0);
+    up.resize(numLevels);
+
+    // Nothing active, the image is zero
+    if(numLevels < 0 || firstLevel > lastLevel) {
+        dst.create(sizes.empty() ? cv::Size() : sizes[0], type);
+        dst.setTo(cv::Scalar::all(0));
+        return;
+    }
+
+    if(lastLevel == 0) {
+        levels[0].copyTo(dst);
+        return;
+    }
+
+    cv::Mat currentLevel = levels[lastLevel];
+    for (int level = lastLevel-1; level >= 0; --level) {
+        // The last step writes straight into dst
+        cv::Mat &upsampled = (level == 0) ? dst : up[level];
+        cv::pyrUp(currentLevel, upsampled, sizes[level]);
+        // Inactive levels below firstLevel are zero, only upsample
+        if(level >= firstLevel)
+            cv::add(upsampled, levels[level], upsampled);
+        currentLevel = upsampled;
+    }
+}
+
+void LaplacePyramid::copyFrom(const LaplacePyramid &other)
+{
+    levels.resize(other.levels.size());
+    for (size_t i = 0; i < levels.size(); ++i)
+        other.levels[i].copyTo(levels[i]);
+    sizes = other.sizes;
+    type = other.type;
+}
+
+int LaplacePyramid::numLevels() const
+{
+    return static_cast<int>(levels.size()) - 1;
+}
+
+cv::Mat &LaplacePyramid::level(int i)
+{
+    return levels[i];
+}
+
+const cv::Mat &LaplacePyramid::level(int i) const
+{
+    return levels[i];
+}
@@ -0,0 +1,89 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->LaplacePyramid.h                                   */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#ifndef LAPLACEPYRAMID_H
+#define LAPLACEPYRAMID_H
+// OpenCV
+#include "opencv2/core/core.hpp"
+#include "opencv2/imgproc/imgproc.hpp"
+// C++
+#include <vector>
+
+/*!
+ * \brief The LaplacePyramid class Laplace Pyramid that keeps its levels and scratch images between frames.
+ *  Every Mat is written with cv::Mat::create semantics, so memory is only allocated when the image size,
+ *  type or number of levels changes. Building and collapsing a pyramid of unchanged configuration
+ *  works in place.
+ *  build and collapse can be restricted to a range of active levels [firstLevel, lastLevel], the other
+ *  levels are treated as zero and neither computed nor added.
+ */
+class LaplacePyramid
+{
+public:
+    LaplacePyramid();
+    /*!
+     * \brief build Fills the pyramid from an image, like buildLaplacePyrFromImg.
+     * \param img Source image.
+     * \param levels Number of times the image is downsampled.
+     * \param firstLevel First level that is computed.
+     * \param lastLevel Last level that is computed, -1 for the smallest image (levels).
+     *  Levels outside of the range are released.
+     */
+    void build(const cv::Mat &img, int levels, int firstLevel = 0, int lastLevel = -1);
+    /*!
+     * \brief collapse Reconstructs the image from the pyramid, like buildImgFromLaplacePyr.
+     * \param dst Destination image. Reused if it already has the size and type of the first level.
+     * \param firstLevel First level that is added. The sum is upsampled to the size of the first level
+     *  without adding the levels below.
+     * \param lastLevel Last level that is added, -1 for the smallest image (numLevels()).
+     */
+    void collapse(cv::Mat &dst, int firstLevel = 0, int lastLevel = -1);
+    /*!
+     * \brief copyFrom Copies the levels of another pyramid, reusing the memory of this one.
+     * \param other Pyramid to copy.
+     */
+    void copyFrom(const LaplacePyramid &other);
+    /*!
+     * \brief numLevels Number of times the image is downsampled, level() is valid from 0 to numLevels().
+     */
+    int numLevels() const;
+    /*!
+     * \brief level Difference image of a level, or the smallest image for level numLevels().
+     */
+    cv::Mat &level(int i);
+    const cv::Mat &level(int i) const;
+
+private:
+    // Laplace levels, last element is the smallest downsampled image
+    std::vector<cv::Mat> levels;
+    // Size of every level and type of the source image, known even for levels that weren't computed
+    std::vector<cv::Size> sizes;
+    int type;
+    // Downsampled images of every level
+    std::vector<cv::Mat> down;
+    // Upsampled images of every level, used by build and collapse
+    std::vector<cv::Mat> up;
+};
+
+#endif // LAPLACEPYRAMID_H
@@ -25,6 +25,8 @@
 #include "main/magnification/Magnificator.h"
 #include "opencv2/opencv.hpp"
 #include <opencv2/core/mat.hpp>
+// C++
+#include <limits>
 
 //using namespace cv;
 ////////////////////////
@@ -46,6 +48,13 @@ Magnificator::Magnificator(std::vector<cv::Mat> *pBuffer,
         lambda = 0;
         delta = 0;
         breathMeasureOutput = 0;
+        rateMeasureOutput = 0;
+        rateConfidenceOutput = 0;
+        chromaFirstLevel = -1;
+        offlineChannels = 0;
+        offlineMin = 0;
+        offlineMax = 0;
+        decimationCount = 0;
     }
 Magnificator::~Magnificator()
 {
@@ -80,75 +89,304 @@ void Magnificator:: colorMagnify() {
     // Magnify only when processing buffer holds new images
     if(currentFrame >= pBufferElements)
         return;
+    // No window needed, every frame is filtered when it arrives
+    if(imgProcFlags->colorIirOn) {
+        colorIirMagnify();
+        return;
+    }
     // Number of levels in pyramid
     //levels = DEFAULT_COL_MAG_LEVELS;
     levels = imgProcSettings->levels;
-    cv::Mat input, output, color, filteredFrame, downSampledFrame, filteredMat;
+    cv::Mat input, filteredFrame, downSampledFrame, filteredRow;
     std::vector<cv::Mat> inputFrames, inputPyramid;
+    // Number of frames pushed to the window up to every input frame
+    std::vector<int> framePushes;
 
     int offset = 0;
+    int pushed = 0;
     int pChannels;
+    // Decimated, the window holds one averaged frame per decimationFactor() frames at the reduced rate
+    const int factor = decimationFactor();
+    const double framerate = imgProcSettings->framerate / factor;
+    const int windowLength = getOptimalBufferSize(framerate);
 
     // Process every frame in buffer that wasn't magnified yet
     while(currentFrame < pBufferElements) {
-        // Grab oldest frame from processingBuffer and delete it to save memory
-        input = processingBuffer->front().clone();
+        // Grab oldest frame from processingBuffer and delete it from there
+        input = processingBuffer->front();
         processingBuffer->erase(processingBuffer->begin());
+        // Save the 8bit input frame to add the color later, only one float frame is alive at a time
+        inputFrames.push_back(input);
 
+        stageTimer.begin();
         // Convert input image to 32bit float
         pChannels = input.channels();
-        if(!(imgProcFlags->grayscaleOn || pChannels <= 2))
-            input.convertTo(input, CV_32FC1);
+        bool filtered = true;
+        if(factor > 1)
+            filtered = decimate(input, colorInput);
+        else if(!(imgProcFlags->grayscaleOn || pChannels <= 2))
+            input.convertTo(colorInput, CV_32FC1);
         else
-            input.convertTo(input, CV_32FC3);
-
-        // Save input frame to add motion later
-        inputFrames.push_back(input);
-
-        /* 1. SPATIAL FILTER, BUILD GAUSS PYRAMID */
-        buildGaussPyrFromImg(input, levels, inputPyramid);
-
-        /* 2. CONCAT EVERY SMALLEST FRAME FROM PYRAMID IN ONE LARGE MAT, 1COL = 1FRAME */
-        downSampledFrame = inputPyramid.at(levels-1);
-        img2tempMat(downSampledFrame, downSampledMat, getOptimalBufferSize(imgProcSettings->framerate));
+            input.convertTo(colorInput, CV_32FC3);
+        stageTimer.end(STAGE_COLOR_CONVERSION);
+
+        if(filtered) {
+            /* 1. SPATIAL FILTER, BUILD GAUSS PYRAMID */
+            buildGaussPyrFromImg(colorInput, levels, inputPyramid);
+
+            /* 2. STORE EVERY SMALLEST FRAME FROM PYRAMID IN A RING BUFFER, 1ROW = 1FRAME */
+            downSampledFrame = inputPyramid.at(levels-1);
+            // The oldest frame drops out of a full window, the sliding DFT needs it
+            downSampledFrames.push(downSampledFrame, windowLength, &leavingFrame);
+            ++pushed;
+            stageTimer.end(STAGE_PYRAMID);
+        }
+        framePushes.push_back(pushed);
 
         // Save how many frames we've currently downsampled
         ++currentFrame;
         ++offset;
     }
 
-    /* 3. TEMPORAL FILTER */
-    idealFilter(downSampledMat, filteredMat, imgProcSettings->coLow, imgProcSettings->coHigh, imgProcSettings->framerate);
+    // Frames in between two averages only reuse the last color image
+    bool sliding = false;
+    if(pushed > 0) {
+        stageTimer.begin();
+        /* 3. TEMPORAL FILTER */
+        // A full window that moved by one frame only updates the passband bins, everything else is filtered at once
+        sliding = (pushed == 1 &&
+                   colorBandpass.isValidFor(downSampledFrames, imgProcSettings->coLow, imgProcSettings->coHigh, framerate));
+        if(sliding) {
+            colorBandpass.slide(downSampledFrames, leavingFrame);
+        }
+        else {
+            // The spectrum is computed anyway, its passband power gives the rate
+            colorFilterPlan.collectPower = imgProcSettings->rateEstimation;
+            idealFilter(downSampledFrames, filteredFrames, imgProcSettings->coLow, imgProcSettings->coHigh, framerate,
+                        colorFilterPlan);
+            if(downSampledFrames.full())
+                colorBandpass.init(downSampledFrames, imgProcSettings->coLow, imgProcSettings->coHigh, framerate);
+            else
+                colorBandpass.reset();
+        }
 
-    /* 4. AMPLIFY */
-    amplifyGaussian(filteredMat, filteredMat);
+        // Dominant frequency of the passband over all pixels of the ROI
+        if(imgProcSettings->rateEstimation) {
+            if(sliding) {
+                colorBandpass.binPower(ratePower);
+                dominantRate(colorBandpass.passbandBins(), ratePower, downSampledFrames.size(), framerate,
+                             rateMeasureOutput, rateConfidenceOutput);
+            }
+            else
+                dominantRate(colorFilterPlan.powerBins, colorFilterPlan.binPower, downSampledFrames.size(),
+                             framerate, rateMeasureOutput, rateConfidenceOutput);
+        }
+        else {
+            rateMeasureOutput = 0;
+            rateConfidenceOutput = 0;
+        }
+        stageTimer.end(STAGE_TEMPORAL);
+    }
 
     // Add amplified image (color) to every frame
-    for (int i = currentFrame-offset; i < currentFrame; ++i) {
+    for (int i = currentFrame-offset, j = 0; i < currentFrame; ++i, ++j) {
+        // Only the first frame that has seen a new window frame extracts its color image
+        const int push = framePushes[j];
+        if(push > 0 && (j == 0 || framePushes[j-1] != push)) {
+            const int position = (factor > 1) ? std::max(downSampledFrames.size() - pushed + push - 1, 0) : i;
+
+            /* 4. DE-CONCAT 1ROW TO DOWNSAMPLED COLOR IMAGE */
+            if(sliding) {
+                colorBandpass.filteredFrame(position, filteredRow);
+                filteredRow.reshape(filteredRow.channels(), downSampledFrame.rows).copyTo(filteredFrame);
+            }
+            else
+                tempMat2img(filteredFrames, position, downSampledFrame.size(), filteredFrame);
 
-        /* 5. DE-CONCAT 1COL TO DOWNSAMPLED COLOR IMAGE */
-        tempMat2img(filteredMat, i, downSampledFrame.size(), filteredFrame);
+            /* 5. AMPLIFY, only the frames that are shown, around the level zero was normalized to */
+            amplifyGaussian(filteredFrame, colorDelta, sliding ? colorBandpass.zeroLevel() : colorFilterPlan.zeroLevel);
+            stageTimer.end(STAGE_AMPLIFY);
+        }
 
-        /* 6. RECONSTRUCT COLOR IMAGE FROM PYRAMID */
-        buildImgFromGaussPyr(filteredFrame, levels, color, input.size());
+        /* 6. RECONSTRUCT COLOR IMAGE AND ADD IT TO THE 8BIT ORIGINAL, into a new image that stays in magnifiedBuffer */
+        cv::Mat output;
+        if(colorDelta.empty())
+            inputFrames.front().copyTo(output);
+        else
+            addGaussDelta(colorDelta, levels, inputFrames.front(), output, colorUpsampled);
+        stageTimer.end(STAGE_COLLAPSE);
 
-        /* 7. ADD COLOR IMAGE TO ORIGINAL IMAGE */
-        output = inputFrames.front()+color;
+        // Fill internal buffer with magnified image
+        magnifiedBuffer.push_back(output);
+        // Delete the currently processed input image
+        inputFrames.erase(inputFrames.begin());
+    }
+    stageTimer.finishFrame();
+}
 
-        // Scale output image an convert back to 8bit unsigned
-        double min,max;
-        minMaxLoc(output, &min, &max);
-        if(!(imgProcFlags->grayscaleOn || pChannels <= 2)) {
-            output.convertTo(output, CV_8UC1, 255.0/(max-min), -min * 255.0/(max-min));
-        } else {
-            output.convertTo(output, CV_8UC3, 255.0/(max-min), -min * 255.0/(max-min));
+bool Magnificator::prepareOfflineColor(int numFrames, const cv::Mat &frame)
+{
+    levels = imgProcSettings->levels;
+
+    // Same Gauss level as colorMagnify, its size doesn't depend on the content
+    std::vector<cv::Mat> inputPyramid;
+    frame.convertTo(colorInput, CV_32F);
+    buildGaussPyrFromImg(colorInput, levels, inputPyramid);
+    const cv::Mat &downSampledFrame = inputPyramid.at(levels-1);
+    offlineSize = downSampledFrame.size();
+    offlineChannels = downSampledFrame.channels();
+
+    offlineCube.reset(new TemporalCube());
+    if(!offlineCube->create(numFrames, offlineSize.area()*offlineChannels, OFFLINE_COLOR_TILE_SERIES)) {
+        offlineCube.reset();
+        return false;
+    }
+    return true;
+}
+
+void Magnificator::addOfflineColorFrame(const cv::Mat &frame)
+{
+    stageTimer.begin();
+    // Convert input image to 32bit float
+    frame.convertTo(colorInput, CV_32F);
+    stageTimer.end(STAGE_COLOR_CONVERSION);
+
+    /* 1. SPATIAL FILTER, BUILD GAUSS PYRAMID */
+    std::vector<cv::Mat> inputPyramid;
+    buildGaussPyrFromImg(colorInput, levels, inputPyramid);
+
+    /* 2. STORE THE SMALLEST FRAME IN THE CUBE */
+    offlineCube->push(inputPyramid.at(levels-1));
+    stageTimer.end(STAGE_PYRAMID);
+}
+
+int Magnificator::filterOfflineColor()
+{
+    const int frames = offlineCube->size();
+    offlineMin = 0;
+    offlineMax = 0;
+    if(frames < 2)
+        return frames;
+
+    stageTimer.begin();
+    /* 3. TEMPORAL FILTER, ONE DFT PER SERIES OVER THE WHOLE VIDEO */
+    // Series are padded to a fast DFT length by mirroring, so the end doesn't jump back to the start
+    const int length = std::min(cv::getOptimalDFTSize(frames), 2*frames-1);
+    cv::Mat series, padded, filtered;
+    double minVal = std::numeric_limits<double>::max();
+    double maxVal = -std::numeric_limits<double>::max();
+    for(int t = 0; t < offlineCube->numTiles(); ++t) {
+        cv::Mat tile = offlineCube->tile(t);
+        cv::transpose(tile, series);
+        if(length > frames)
+            cv::copyMakeBorder(series, padded, 0, 0, 0, length-frames, cv::BORDER_REFLECT_101);
+        else
+            padded = series;
+
+        idealBandpass(padded, filtered, imgProcSettings->coLow, imgProcSettings->coHigh, imgProcSettings->framerate,
+                      colorFilterPlan);
+        const cv::Mat result = filtered.colRange(0, frames);
+        double tileMin, tileMax;
+        cv::minMaxLoc(result, &tileMin, &tileMax);
+        minVal = std::min(minVal, tileMin);
+        maxVal = std::max(maxVal, tileMax);
+
+        // Back into the cube, the tile keeps its memory
+        cv::transpose(result, tile);
+    }
+    offlineMin = static_cast<float>(minVal);
+    offlineMax = static_cast<float>(maxVal);
+    stageTimer.end(STAGE_TEMPORAL);
+    stageTimer.finishFrame();
+    return frames;
+}
+
+cv::Mat Magnificator::offlineColorFrame(const cv::Mat &frame, int position)
+{
+    cv::Mat filteredFrame, output;
+
+    stageTimer.begin();
+    /* 4. DE-CONCAT 1ROW TO DOWNSAMPLED COLOR IMAGE, scaled with the range of the whole video like idealFilter */
+    offlineCube->frame(position, offlineRow);
+    const float range = offlineMax - offlineMin;
+    offlineRow.reshape(offlineChannels, offlineSize.height).convertTo(
+                filteredFrame, -1, range > 0 ? 1.0/range : 0.0);
+
+    /* 5. AMPLIFY, the bandpass output is still zero mean */
+    amplifyGaussian(filteredFrame, filteredFrame);
+    stageTimer.end(STAGE_AMPLIFY);
+
+    /* 6. RECONSTRUCT COLOR IMAGE AND ADD IT TO THE 8BIT ORIGINAL */
+    addGaussDelta(filteredFrame, levels, frame, output, colorUpsampled);
+    stageTimer.end(STAGE_COLLAPSE);
+    stageTimer.finishFrame();
+
+    return output;
+}
+
+void Magnificator::releaseOfflineColor()
+{
+    offlineCube.reset();
+}
+
+void Magnificator::colorIirMagnify()
+{
+    int pBufferElements = processingBuffer->size();
+    levels = imgProcSettings->levels;
+    cv::Mat input, downSampledFrame;
+    std::vector<cv::Mat> inputPyramid;
+    int pChannels;
+    // Decimated, the filter runs on one averaged frame per decimationFactor() frames at the reduced rate
+    const int factor = decimationFactor();
+
+    // Process every frame in buffer that wasn't magnified yet
+    while(currentFrame < pBufferElements) {
+        // Grab oldest frame from processingBuffer and delete it from there
+        input = processingBuffer->front();
+        processingBuffer->erase(processingBuffer->begin());
+
+        stageTimer.begin();
+        // Convert input image to 32bit float, like colorMagnify
+        pChannels = input.channels();
+        bool filtered = true;
+        if(factor > 1)
+            filtered = decimate(input, colorInput);
+        else if(!(imgProcFlags->grayscaleOn || pChannels <= 2))
+            input.convertTo(colorInput, CV_32FC1);
+        else
+            input.convertTo(colorInput, CV_32FC3);
+        stageTimer.end(STAGE_COLOR_CONVERSION);
+
+        // Frames in between two averages only reuse the last color image
+        if(filtered) {
+            /* 1. SPATIAL FILTER, BUILD GAUSS PYRAMID */
+            buildGaussPyrFromImg(colorInput, levels, inputPyramid);
+            downSampledFrame = inputPyramid.at(levels-1);
+            stageTimer.end(STAGE_PYRAMID);
+
+            /* 2. TEMPORAL FILTER, O(1) STATE PER PIXEL, designed for the rate it runs at */
+            colorIirBandpass.filter(downSampledFrame, colorIirFrame, imgProcSettings->coLow, imgProcSettings->coHigh,
+                                    imgProcSettings->framerate / factor);
+            stageTimer.end(STAGE_TEMPORAL);
+
+            /* 3. AMPLIFY */
+            amplifyGaussian(colorIirFrame, colorIirFrame);
+            stageTimer.end(STAGE_AMPLIFY);
         }
 
+        /* 4. RECONSTRUCT COLOR IMAGE AND ADD IT TO THE 8BIT ORIGINAL, into a new image that stays in magnifiedBuffer */
+        cv::Mat output;
+        if(colorIirFrame.empty())
+            input.copyTo(output);
+        else
+            addGaussDelta(colorIirFrame, levels, input, output, colorUpsampled);
+        stageTimer.end(STAGE_COLLAPSE);
+
         // Fill internal buffer with magnified image
         magnifiedBuffer.push_back(output);
-        // Delete the currently processed input image
-        inputFrames.erase(inputFrames.begin());
+        ++currentFrame;
     }
+    stageTimer.finishFrame();
 }
 
 
@@ -182,10 +420,8 @@ string type2str(int type) {
 
 bool compareContoursPerimeter(vector<cv::Point> cont1, vector<cv::Point> cont2) { return cv::arcLength(cont1, 0) > cv::arcLength(cont2, 0); }
 
-bool compareContoursArea(vector<cv::Point> cont1, vector<cv::Point> cont2) { return cv::contourArea(cont1) > cv::contourArea(cont2); }
 
 int prevAvgContoursSum = 0;
-int first = 1;
 void Magnificator::laplaceMagnify() {
     int pBufferElements = processingBuffer->size();
     // Magnify only when processing buffer holds new images
@@ -194,82 +430,160 @@ void Magnificator::laplaceMagnify() {
     // Number of levels in pyramid
 //    levels = DEFAULT_LAP_MAG_LEVELS;
     levels = imgProcSettings->levels;
+    // Level 0 and the lowpassed image are never amplified (see laplaceAmplification()), so only
+    // the levels in between are built, filtered and collapsed
+    const int firstLevel = 1;
+    const int lastLevel = std::max(levels-1, 0);
 
-    cv::Mat input, output, motion, hsvimg, labimg, newestMotion, preparedFrame, firstContours, temp;
-    vector<cv::Mat> inputPyramid;
+    cv::Mat input, output, temp;
+    cv::Mat &motion = motionFrame;
     int pChannels;
+    // Decimated, the pyramids are filtered with one averaged frame per decimationFactor() frames
+    const int factor = decimationFactor();
 
     // Process every frame in buffer that wasn't magnified yet
     while(currentFrame < pBufferElements) {
         // Grab oldest frame from processingBuffer and delete it to save memory
-        input = processingBuffer->front().clone();
+        const cv::Mat &bufferFront = processingBuffer->front();
         if(currentFrame == 0) {
-            prevFrame = input; // save first raw input as prevFrame (for motion)
+            prevFrame = bufferFront.clone(); // save first raw input as prevFrame (for motion)
         }
 
-            else {
-                processingBuffer->erase(processingBuffer->begin()); // delete oldest frame
-//                cv::imshow("First", prevFrame); // NOTE using imshow does not close the program.
-        }
-
-
-        // Convert input image to 32bit float
-        pChannels = input.channels();
+        stageTimer.begin();
+        // Convert input image to 32bit float, into buffers that are reused every frame
+        pChannels = bufferFront.channels();
         if(!(imgProcFlags->grayscaleOn || pChannels <= 2)) {
             // Convert color images to YCrCb
-            input.convertTo(input, CV_32FC3, 1.0/255.0f);
-            cvtColor(input, input, cv::COLOR_BGR2YCrCb);
+            bufferFront.convertTo(convertedFrame, CV_32FC3, 1.0/255.0f);
+            cvtColor(convertedFrame, inputFrame, cv::COLOR_BGR2YCrCb);
         }
         else
-            input.convertTo(input, CV_32FC1, 1.0/255.0f);
+            bufferFront.convertTo(inputFrame, CV_32FC1, 1.0/255.0f);
+        input = inputFrame;
+
+        // The first frame starts the filters, after it only the average of every factor frames is filtered
+        bool filterFrame = true;
+        if(currentFrame == 0)
+            decimationCount = 0;
+        else if(factor > 1)
+            filterFrame = decimate(input, decimatedFrame);
+        const cv::Mat &filterInput = (currentFrame > 0 && factor > 1) ? decimatedFrame : input;
+        stageTimer.end(STAGE_COLOR_CONVERSION);
 
-        /* 1. SPATIAL FILTER, BUILD LAPLACE PYRAMID */
-        buildLaplacePyrFromImg(input, levels, inputPyramid);
+        if(currentFrame > 0) {
+            processingBuffer->erase(processingBuffer->begin()); // delete oldest frame
+//            cv::imshow("First", prevFrame); // NOTE using imshow does not close the program.
+        }
 
-        // If first frame ever, save unfiltered pyramid
-        if(currentFrame == 0) {
-            lowpassHi = inputPyramid;
-            lowpassLo = inputPyramid;
-            motionPyramid = inputPyramid;
-        } else {
-            /* 2. TEMPORAL FILTER EVERY LEVEL OF LAPLACE PYRAMID */
-            for (int curLevel = 0; curLevel < levels; ++curLevel) {
-                iirFilter(inputPyramid.at(curLevel), motionPyramid.at(curLevel), lowpassHi.at(curLevel), lowpassLo.at(curLevel),
-                          imgProcSettings->coLow, imgProcSettings->coHigh);
+        // Colored frames are processed planar: luma always, chroma only if it isn't attenuated to 0
+        const bool colored = (input.channels() == 3);
+
+        // Frames in between two averages skip everything up to the output, they reuse the last motion image
+        if(filterFrame) {
+            const double chromAttenuation = imgProcSettings->chromAttenuation;
+            int chromaFirst = -1;
+            if(colored && chromAttenuation > 0)
+                chromaFirst = (chromAttenuation < LAP_MAG_REDUCED_CHROMA_ATTENUATION) ? firstLevel+1 : firstLevel;
+            if(colored) {
+                cv::extractChannel(filterInput, lumaFrame, 0);
+                if(chromaFirst >= 0) {
+                    chromaFrame.create(filterInput.size(), CV_32FC2);
+                    static const int fromTo[] = { 1,0, 2,1 };
+                    cv::mixChannels(&filterInput, 1, &chromaFrame, 1, fromTo, 2);
+                }
+            }
+            const cv::Mat &luma = colored ? lumaFrame : filterInput;
+
+            /* 1. SPATIAL FILTER, BUILD LAPLACE PYRAMID */
+            inputPyramid.build(luma, levels, firstLevel, lastLevel);
+            if(chromaFirst >= 0)
+                chromaPyramid.build(chromaFrame, levels, chromaFirst, lastLevel);
+            stageTimer.end(STAGE_PYRAMID);
+
+            // If first frame ever, save unfiltered pyramid
+            if(currentFrame == 0) {
+                lowpassHi.copyFrom(inputPyramid);
+                lowpassLo.copyFrom(inputPyramid);
+                motionPyramid.copyFrom(inputPyramid);
+            }
+            // Same for chroma, whenever it is switched on or its resolution changed
+            if(chromaFirst >= 0 && (currentFrame == 0 || chromaFirst != chromaFirstLevel)) {
+                chromaLowpassHi.copyFrom(chromaPyramid);
+                chromaLowpassLo.copyFrom(chromaPyramid);
+                chromaMotionPyramid.copyFrom(chromaPyramid);
+            }
+            chromaFirstLevel = chromaFirst;
+
+            if(currentFrame > 0) {
+                int w = input.size().width;
+                int h = input.size().height;
+
+                // Amplification variable
+                delta = imgProcSettings->coWavelength / (8.0 * (1.0 + imgProcSettings->amplification));
+
+                // Amplification Booster for better visualization
+                exaggeration_factor = DEFAULT_LAP_MAG_EXAGGERATION;
+
+                // compute representative wavelength, lambda, of firstLevel
+                // doubles for every coarser pyramid level
+                lambda = sqrt(w*w + h*h)/3.0 / std::pow(2.0, levels-firstLevel);
+
+                // Lowpass weights per filtered frame, with the time constants of the full rate
+                const double coLow = decimatedCutoff(imgProcSettings->coLow);
+                const double coHigh = decimatedCutoff(imgProcSettings->coHigh);
+
+                /* 2. TEMPORAL FILTER AND 3. AMPLIFY EVERY ACTIVE LEVEL OF LAPLACE PYRAMID, in one pass per level */
+                for (int curLevel = firstLevel; curLevel <= lastLevel; ++curLevel) {
+                    const float amplification = laplaceAmplification(curLevel);
+                    iirBandpassAmplify(inputPyramid.level(curLevel), motionPyramid.level(curLevel),
+                                       lowpassHi.level(curLevel), lowpassLo.level(curLevel),
+                                       coLow, coHigh, amplification);
+                    // Chroma is attenuated right away, it's linear up to the output
+                    if(chromaFirst >= 0 && curLevel >= chromaFirst)
+                        iirBandpassAmplify(chromaPyramid.level(curLevel), chromaMotionPyramid.level(curLevel),
+                                           chromaLowpassHi.level(curLevel), chromaLowpassLo.level(curLevel),
+                                           coLow, coHigh, amplification*chromAttenuation);
+                    lambda *= 2.0;
+                }
+                stageTimer.end(STAGE_TEMPORAL);
             }
 
-            int w = input.size().width;
-            int h = input.size().height;
-
-            // Amplification variable
-            delta = imgProcSettings->coWavelength / (8.0 * (1.0 + imgProcSettings->amplification));
-
-            // Amplification Booster for better visualization
-            exaggeration_factor = DEFAULT_LAP_MAG_EXAGGERATION;
-
-            // compute representative wavelength, lambda
-            // reduces for every pyramid level
-            lambda = sqrt(w*w + h*h)/3.0;
-
-            /* 3. AMPLIFY EVERY LEVEL OF LAPLACE PYRAMID */
-            for (int curLevel = levels; curLevel >= 0; --curLevel) {
-                amplifyLaplacian(motionPyramid.at(curLevel), motionPyramid.at(curLevel), curLevel);
-                lambda /= 2.0;
+            // Motion is nothing up until this point
+            /* 4. RECONSTRUCT MOTION IMAGE FROM PYRAMID */
+            // Upsamples the sum of the active levels straight to the input size
+            if(!colored) {
+                motionPyramid.collapse(motion, firstLevel, lastLevel);
+            }
+            else {
+                motionPyramid.collapse(lumaMotion, firstLevel, lastLevel);
+                // 5. ATTENUATE: chroma is either left out (0) or was attenuated while filtering
+                if(chromaFirst >= 0) {
+                    chromaMotionPyramid.collapse(chromaMotion, chromaFirst, lastLevel);
+                    const cv::Mat planes[] = { lumaMotion, chromaMotion };
+                    static const int fromTo[] = { 0,0, 1,1, 2,2 };
+                    motion.create(input.size(), CV_32FC3);
+                    cv::mixChannels(planes, 2, &motion, 1, fromTo, 3);
+                }
+                else {
+                    if(zeroPlane.size() != input.size() || zeroPlane.type() != CV_32FC1)
+                        zeroPlane = cv::Mat::zeros(input.size(), CV_32FC1);
+                    const cv::Mat planes[] = { lumaMotion, zeroPlane, zeroPlane };
+                    cv::merge(planes, 3, motion);
+                }
             }
+            // Frames before the first filtered average have no motion
+            if(currentFrame == 0 && factor > 1)
+                motion.setTo(cv::Scalar::all(0));
+            stageTimer.end(STAGE_COLLAPSE);
         }
 
-        // Motion is nothing up until this point
-        /* 4. RECONSTRUCT MOTION IMAGE FROM PYRAMID */
-        buildImgFromLaplacePyr(motionPyramid, levels, motion);
-
-
-
-        /* 5. ATTENUATE (if not grayscale) */
-        attenuate(motion, motion);
+        // Analysis only: the magnified image is neither built nor converted, the breath value only needs temp
+        const bool analysisOnly = imgProcFlags->analysisOnlyOn;
 
         /* 6. ADD MOTION TO ORIGINAL IMAGE */
         if(currentFrame > 0) {
-            output = input+motion; // used in original
+            if(!analysisOnly)
+                output = input+motion; // used in original
             temp = motion;
 //             output = motion;
 //            output = hsvimg;
@@ -280,7 +594,10 @@ void Magnificator::laplaceMagnify() {
         }
 
         // Scale output image an convert back to 8bit unsigned
-        if(!(imgProcFlags->grayscaleOn || pChannels <= 2)) {
+        if(analysisOnly) {
+            // Nothing to show
+        }
+        else if(!(imgProcFlags->grayscaleOn || pChannels <= 2)) {
             // Convert YCrCb image back to BGR
             cvtColor(output, output, cv::COLOR_YCrCb2BGR);
             output.convertTo(output, CV_8UC3, 255.0, 1.0/255.0);
@@ -289,49 +606,44 @@ void Magnificator::laplaceMagnify() {
             output.convertTo(output, CV_8UC1, 255.0, 1.0/255.0);
         }
 
-        if(!(imgProcFlags->grayscaleOn || pChannels <= 2)) {
+        // Only filtered frames update the breath value. temp is converted into breathFrame, motion is reused
+        if(!filterFrame) {
+            // Nothing to detect
+        }
+        else if(!(imgProcFlags->grayscaleOn || pChannels <= 2)) {
             // Convert YCrCb image back to BGR
-            cvtColor(temp, temp, cv::COLOR_YCrCb2BGR);
-            temp.convertTo(temp, CV_8UC3, 255.0, 1.0/255.0);
+            cvtColor(temp, convertedFrame, cv::COLOR_YCrCb2BGR);
+            convertedFrame.convertTo(breathFrame, CV_8UC3, 255.0, 1.0/255.0);
         }
         else {
-            temp.convertTo(temp, CV_8UC1, 255.0, 1.0/255.0);
+            temp.convertTo(breathFrame, CV_8UC1, 255.0, 1.0/255.0);
         }
+        stageTimer.end(STAGE_COLOR_CONVERSION);
 
         // detect motion between input and prevFrame. on 2nd+ frame. Then set prevFrame to input.
         // based upon https://towardsdatascience.com/image-analysis-for-beginners-creating-a-motion-detector-with-opencv-4ca6faba4b42
-        if (currentFrame > 0) {
-            newestMotion = temp;
+        if (currentFrame > 0 && filterFrame) {
+            // Every image of the detection is a member written with create semantics, so nothing is allocated
+            // once the frame size is settled. Filters never run in place.
+            static const cv::Mat one = cv::Mat::ones(2, 2, CV_8UC1);
 
             // convert prevFrame
-            cvtColor(prevFrame, prevFrame, cv::COLOR_BGR2GRAY);
-            cv::GaussianBlur(prevFrame, prevFrame, cv::Size(5,5), 0, 0);
-            prevFrame.convertTo(prevFrame, CV_8UC1, 255.0, 1.0/255.0);
+            cvtColor(prevFrame, breathGray, cv::COLOR_BGR2GRAY);
+            cv::GaussianBlur(breathGray, breathBlurred, cv::Size(5,5), 0, 0);
+            breathBlurred.convertTo(breathPrev, CV_8UC1, 255.0, 1.0/255.0);
 
-            // convert newestMotion as a gray of output
-            cvtColor(temp, newestMotion, cv::COLOR_BGR2GRAY);
-            cv::GaussianBlur(newestMotion, newestMotion, cv::Size(5,5), 0, 0);
-
-            preparedFrame = prevFrame;
+            // convert the newest motion as a gray of output
+            cvtColor(breathFrame, breathMotion, cv::COLOR_BGR2GRAY);
+            cv::GaussianBlur(breathMotion, breathDiff, cv::Size(5,5), 0, 0);
 
             // Dif between previous, raw frame and newst output frame
-            cv::absdiff(prevFrame, newestMotion, preparedFrame);
-
-            cv::Mat one = cv::Mat::ones(2, 2, CV_8UC1);
+            cv::absdiff(breathPrev, breathDiff, breathDiff);
 
-            cv::dilate(preparedFrame, preparedFrame, one, cv::Point(-1,-1), 1);
+            cv::dilate(breathDiff, breathMask, one, cv::Point(-1,-1), 1);
 
-            cv::Mat threshFrame;
-            cv::threshold(preparedFrame, threshFrame, 20, 255, cv::THRESH_BINARY); // 20, 255 are the thresholds.
+            cv::threshold(breathMask, breathMask, 20, 255, cv::THRESH_BINARY); // 20, 255 are the thresholds.
 
-            bitwise_not(threshFrame, threshFrame); // invert image so foreground is white, background is black. (contours detct white on black)
-
-            // threshold frame honestly looks pretty good, if can find countours in that then do area from the tutorial, etc.
-            temp = threshFrame; // Set the output to threshold frame.
-
-
-            cvtColor(temp, temp, cv::COLOR_GRAY2BGR);
-//            cv::imshow("BGR", output); // here it's white and black, looks pretty decent.
+            bitwise_not(breathMask, breathMask); // invert image so foreground is white, background is black. (contours detct white on black)
 
             // TODO: things to improve detection:
             // FIND CLUSTERS OF CONTOURS sthat move together and track them.
@@ -339,66 +651,23 @@ void Magnificator::laplaceMagnify() {
             // maybe try Hull from OpenCV?
 
             // contours approach
-            vector<vector<cv::Point>> contours;
-            cv::findContours(threshFrame, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_TC89_L1);
-
-            // init finalFrame
-            cv::Mat finalFrame = cv::Mat::zeros(input.size().height, input.size().width, CV_8UC3);
-
-            // sort in descending from largest to smallest contour (based on contour area).
-            std::sort(contours.begin(), contours.end(), compareContoursArea);
-
-            int numContours = contours.size();
-
-            int desiredLongest = 50;
-            // draw contours on cv::Mat frame.
-            for (int i = 0; i < std::min(numContours, desiredLongest); i++) {
-                cv::drawContours(finalFrame, contours, i, cv::Scalar(0,255,0), 2, cv::LINE_AA);
-            }
-
-            // Toggle between showing the contours or magnified image based on button
-            if (imgProcSettings->MagnifiedOrContours) {
-                output = finalFrame; // this is the frame after contours have been added.
-            }
-
-            // save the very first contours frame
-            if (first) {
-                firstContours = temp;
-            } else {
-                temp = finalFrame - firstContours;
-            }
-
-
-            // Iterate through up to the desiredLongest largest contours.
-            int contoursSum = 0;
+            int contoursSum = breathExtractor.extract(breathMask, imgProcSettings->breathMethod);
 
-            for (size_t i = 0; i < std::min(numContours, desiredLongest); i++) {
-                // Contours is a vector of contours(which are stored as point vectors)
-                vector<cv::Point> pont = contours[i]; // pont is a contour defined as a vector consistuing of multiple points.
-                int ySum = 0;
+            // Only drawn if they are shown instead of the magnified image
+            if(!analysisOnly && imgProcSettings->MagnifiedOrContours) {
+                // init the contours frame
+                breathContours.create(input.size(), CV_8UC3);
+                breathContours.setTo(cv::Scalar::all(0));
 
+                // draw the up to BREATH_NUM_REGIONS largest contours on cv::Mat frame.
+                breathExtractor.draw(breathContours);
 
-                for (size_t j = 0; j < pont.size(); j++) {
-                    ySum += pont[j].y; // A y coord of one the the vector points.
-                    // use this if want to get minimum y-value.
-//                    if (pont[j].y < ySum) {
-//                        ySum = pont[j].y;
-//                    }
-                }
-                // avg y of this contour
-                ySum /= pont.size();
-
-                contoursSum += ySum;
-            }
-
-            // if only 7 contours, likely not breathing.
-            if (numContours <= 7) {
-                contoursSum = 0;
-            } else {
-                contoursSum = contoursSum / std::min(numContours, desiredLongest);
+                // Toggle between showing the contours or magnified image based on button.
+                // output is a fresh Mat that stays in magnifiedBuffer, breathContours is drawn again next frame
+                breathContours.copyTo(output);
             }
 
-//            cout << "Avg contours y-value: " << contoursSum << " # contours: " << std::min(numContours, desiredLongest) << " Contours. " << endl;
+//            cout << "Avg contours y-value: " << contoursSum << " # contours: " << breathExtractor.numRegions() << " Contours. " << endl;
 
 
             // set initial prevavgcontourssum if first frame.
@@ -423,11 +692,14 @@ void Magnificator::laplaceMagnify() {
 //                        1.0,
 //                        CV_RGB(118, 185, 0), //font color
 //                        2);
-            prevFrame = input;
+            // input is overwritten by the next frame
+            input.copyTo(prevFrame);
+            stageTimer.end(STAGE_BREATH);
         }
+        stageTimer.finishFrame();
 
-        // Fill internal buffer with magnified image
-        magnifiedBuffer.push_back(output);
+        // Fill internal buffer with magnified image, an empty one keeps the buffer in step if there is none
+        magnifiedBuffer.push_back(analysisOnly ? cv::Mat() : output);
         ++currentFrame;
     }
 }
@@ -446,6 +718,8 @@ void Magnificator::rieszMagnify()
     std::vector<cv::Mat> channels;
     int pChannels;
     static const double PI_PERCENT = M_PI / 100.0;
+    // Decimated, the pyramid is built from one averaged frame per decimationFactor() frames
+    const int factor = decimationFactor();
 
     // Process every frame in buffer that wasn't magnified yet
     while(currentFrame < pBufferElements)
@@ -457,6 +731,7 @@ void Magnificator::rieszMagnify()
             processingBuffer->erase(processingBuffer->begin());
         }
 
+        stageTimer.begin();
         // Convert input image to 32bit float
         pChannels = buffer_in.channels();
         if(!(imgProcFlags->grayscaleOn || pChannels <= 2))
@@ -471,9 +746,19 @@ void Magnificator::rieszMagnify()
         {
             buffer_in.convertTo(input, CV_32FC1, 1.0/255.0);
         }
+        stageTimer.end(STAGE_COLOR_CONVERSION);
+
+        // The first frame starts the filters, after it only the average of every factor frames is filtered.
+        // The frames in between reuse the last motion
+        const bool firstFrame = !(curPyr && oldPyr && loCutoff && hiCutoff);
+        bool filterFrame = true;
+        if(firstFrame)
+            decimationCount = 0;
+        else if(factor > 1)
+            filterFrame = decimate(input, decimatedFrame);
 
         // If first frame ever, init pointer and init class
-        if( !(curPyr && oldPyr && loCutoff && hiCutoff) )
+        if(firstFrame)
         {
             curPyr.reset();
             oldPyr.reset();
@@ -482,15 +767,16 @@ void Magnificator::rieszMagnify()
             // Pyramids
             curPyr = std::shared_ptr<RieszPyramid>(new RieszPyramid());
             oldPyr = std::shared_ptr<RieszPyramid>(new RieszPyramid());
-            curPyr->init(input, levels);
-            oldPyr->init(input, levels);
-            // Temporal Bandpass Filters, low and highpass (Butterworth)
-            loCutoff = std::shared_ptr<RieszTemporalFilter>(new RieszTemporalFilter(imgProcSettings->coLow, imgProcSettings->framerate));
-            hiCutoff = std::shared_ptr<RieszTemporalFilter>(new RieszTemporalFilter(imgProcSettings->coHigh, imgProcSettings->framerate));
+            curPyr->init(input, levels, imgProcFlags->rieszFastOn);
+            oldPyr->init(input, levels, imgProcFlags->rieszFastOn);
+            // Temporal Bandpass Filters, low and highpass (Butterworth), designed for the rate they run at
+            const double framerate = imgProcSettings->framerate / factor;
+            loCutoff = std::shared_ptr<RieszTemporalFilter>(new RieszTemporalFilter(imgProcSettings->coLow, framerate));
+            hiCutoff = std::shared_ptr<RieszTemporalFilter>(new RieszTemporalFilter(imgProcSettings->coHigh, framerate));
             loCutoff->computeCoefficients();
             hiCutoff->computeCoefficients();
         }
-        else
+        else if(filterFrame)
         {
             // Check if temporal filter setting was updated
             // Update low and highpass butterworth filter coefficients if changed in GUI
@@ -503,8 +789,10 @@ void Magnificator::rieszMagnify()
                 hiCutoff->updateFrequency(imgProcSettings->coHigh);
             }
 
+            stageTimer.begin();
             /* 1. BUILD RIESZ PYRAMID */
-            curPyr->buildPyramid(input);
+            curPyr->buildPyramid(factor > 1 ? decimatedFrame : input);
+            stageTimer.end(STAGE_PYRAMID);
             /* 2. UNWRAPE PHASE TO GET HORIZ&VERTICAL / SIN&COS */
             curPyr->unwrapOrientPhase(*oldPyr);
             // 3. BANDPASS FILTER ON EACH LEVEL
@@ -517,16 +805,30 @@ void Magnificator::rieszMagnify()
                               curPyr->pyrLevels[lvl].itsPhase,
                               oldPyr->pyrLevels[lvl].itsPhase);
             }
-            // Shift current to prior for next iteration
-            *oldPyr = *curPyr;
+            stageTimer.end(STAGE_TEMPORAL);
             // 4. AMPLIFY MOTION
             curPyr->amplify(imgProcSettings->amplification, imgProcSettings->coWavelength*PI_PERCENT);
+            // Shift current to prior for next iteration. amplify kept itsLp, so the frames are swapped instead of copied
+            curPyr->swapFrame(*oldPyr);
+            stageTimer.end(STAGE_AMPLIFY);
         }
 
         /* 6. ADD MOTION TO ORIGINAL IMAGE */
-        if(currentFrame > 0)
+        if(currentFrame > 0 && factor > 1)
+        {
+            // The motion of the average is what the collapsed pyramid adds to it
+            if(filterFrame)
+                cv::subtract(curPyr->collapsePyramid(), decimatedFrame, rieszMotion);
+            if(rieszMotion.empty())
+                magnified = input;
+            else
+                cv::add(input, rieszMotion, magnified);
+            stageTimer.end(STAGE_COLLAPSE);
+        }
+        else if(currentFrame > 0)
         {
             magnified = curPyr->collapsePyramid();
+            stageTimer.end(STAGE_COLLAPSE);
         }
         else
         {
@@ -546,6 +848,8 @@ void Magnificator::rieszMagnify()
         {
             magnified.convertTo(output, CV_8UC1, 255.0, 1.0/255.0);
         }
+        stageTimer.end(STAGE_COLOR_CONVERSION);
+        stageTimer.finishFrame();
 
         // Fill internal buffer with magnified image
         magnifiedBuffer.push_back(output);
@@ -608,15 +912,25 @@ void Magnificator::clearBuffer()
 {
     // Clear internal cache
     this->magnifiedBuffer.clear();
-    this->lowpassHi.clear();
-    this->lowpassLo.clear();
-    this->motionPyramid.clear();
-    this->downSampledMat = cv::Mat();
+    // Laplace pyramids keep their memory, they are refilled from the first frame after clearing
+    this->downSampledFrames.clear();
+    colorBandpass.reset();
+    colorFilterPlan.reset();
+    colorIirBandpass.reset();
+    colorIirFrame.release();
+    colorDelta.release();
+    offlineCube.reset();
+    rateMeasureOutput = 0;
+    rateConfidenceOutput = 0;
     this->currentFrame = 0;
+    this->chromaFirstLevel = -1;
+    stageTimer.clear();
     oldPyr.reset();
     curPyr.reset();
     loCutoff.reset();
     hiCutoff.reset();
+    rieszMotion.release();
+    decimationCount = 0;
 }
 
 
@@ -638,31 +952,54 @@ int Magnificator::getOptimalBufferSize(int fps)
 }
 
 ////////////////////////
-///Postprocessing //////
+///Decimation //////////
 ////////////////////////
-void Magnificator::amplifyLaplacian(const cv::Mat &src, cv::Mat &dst, int currentLevel)
+int Magnificator::decimationFactor() const
 {
-    float currAlpha = (lambda/(delta*8.0) - 1.0) * exaggeration_factor;
-    // Set lowpassed&downsampled image and difference image with highest resolution to 0,
-    // amplify every other level
-    dst = (currentLevel == levels || currentLevel == 0) ? src * 0
-                                                        : src * std::min((float)imgProcSettings->amplification, currAlpha);
+    return std::max(imgProcSettings->decimation, 1);
 }
 
-void Magnificator::attenuate(const cv::Mat &src, cv::Mat &dst)
+bool Magnificator::decimate(const cv::Mat &frame, cv::Mat &averaged)
 {
-    // Attenuate only if image is not grayscale
-    if(src.channels() > 2)
-    {
-        cv::Mat planes[3];
-        split(src, planes);
-        planes[1] = planes[1] * imgProcSettings->chromAttenuation;
-        planes[2] = planes[2] * imgProcSettings->chromAttenuation;
-        merge(planes, 3, dst);
+    // Box filter over the group, so what moves faster than the reduced rate doesn't alias into the passband
+    if(decimationCount == 0 || decimationSum.size() != frame.size() || decimationSum.channels() != frame.channels()) {
+        frame.convertTo(decimationSum, CV_32F);
+        decimationCount = 1;
+    }
+    else {
+        cv::accumulate(frame, decimationSum);
+        ++decimationCount;
     }
+    if(decimationCount < decimationFactor())
+        return false;
+
+    decimationSum.convertTo(averaged, CV_32F, 1.0/decimationCount);
+    decimationCount = 0;
+    return true;
+}
+
+double Magnificator::decimatedCutoff(double cutoff) const
+{
+    // factor steps of lowpass = (1-cutoff)*lowpass + cutoff*src keep (1-cutoff)^factor of the old lowpass
+    cutoff = std::min(std::max(cutoff, 0.0), 1.0);
+    return 1.0 - std::pow(1.0 - cutoff, decimationFactor());
+}
+
+////////////////////////
+///Postprocessing //////
+////////////////////////
+float Magnificator::laplaceAmplification(int currentLevel)
+{
+    float currAlpha = (lambda/(delta*8.0) - 1.0) * exaggeration_factor;
+    // Set lowpassed&downsampled image and difference image with highest resolution to 0,
+    // amplify every other level
+    if(currentLevel == levels || currentLevel == 0)
+        return 0;
+    return std::min((float)imgProcSettings->amplification, currAlpha);
 }
 
-void Magnificator::amplifyGaussian(const cv::Mat &src, cv::Mat &dst)
+void Magnificator::amplifyGaussian(const cv::Mat &src, cv::Mat &dst, double zeroLevel)
 {
-    dst = src * imgProcSettings->amplification;
+    const double alpha = imgProcSettings->amplification;
+    src.convertTo(dst, -1, alpha, -alpha * zeroLevel);
 }
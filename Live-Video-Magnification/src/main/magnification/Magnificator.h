@@ -38,9 +38,13 @@
 // Local
 #include "main/magnification/SpatialFilter.h"
 #include "main/magnification/TemporalFilter.h"
+#include "main/magnification/TemporalCube.h"
 #include "main/other/Structures.h"
 #include "main/other/Config.h"
 #include "main/magnification/RieszPyramid.h"
+#include "main/magnification/LaplacePyramid.h"
+#include "main/magnification/BreathExtractor.h"
+#include "main/helper/StageTimer.h"
 // C++
 #include "cmath"
 #include "math.h"
@@ -89,8 +93,37 @@ public:
     void laplaceMagnify();
     /*!
      * \brief colorMagnify Color magnification. You can find detailed step by step description in .cpp
+     *  With ImageProcessingFlags::colorIirOn the causal variant colorIirMagnify is used.
      */
     void colorMagnify();
+    /*!
+     * \brief prepareOfflineColor (Offline color magnification) Color magnification of a whole video with one DFT
+     *  per series instead of one per window: every frame is added with addOfflineColorFrame, filterOfflineColor
+     *  filters all of them at once and offlineColorFrame magnifies them one by one.
+     * \param numFrames Number of frames of the video.
+     * \param frame First frame, only used for its size. It is not added.
+     * \return False if the temporal cube couldn't be created, colorMagnify has to be used then.
+     */
+    bool prepareOfflineColor(int numFrames, const cv::Mat &frame);
+    /*!
+     * \brief addOfflineColorFrame Adds the smallest Gauss level of the next frame to the temporal cube.
+     */
+    void addOfflineColorFrame(const cv::Mat &frame);
+    /*!
+     * \brief filterOfflineColor Bandpass filters every series of the cube, tile by tile.
+     * \return Number of frames that can be magnified.
+     */
+    int filterOfflineColor();
+    /*!
+     * \brief offlineColorFrame Magnified frame, like colorMagnify would return it.
+     * \param frame Original frame, the same that was added at this position.
+     * \param position Number of the frame, 0 for the first one.
+     */
+    cv::Mat offlineColorFrame(const cv::Mat &frame, int position);
+    /*!
+     * \brief releaseOfflineColor Deletes the temporal cube.
+     */
+    void releaseOfflineColor();
     /*!
      * \brief waveletMagnify Haar Wavelet magnification. You can find detailed step by step description in .cpp
      */
@@ -139,6 +172,17 @@ public:
     int getOptimalBufferSize(int fps);
 
     int breathMeasureOutput;
+    /*!
+     * \brief rateMeasureOutput (Color magnification) Dominant rate of the passband per minute, e.g. the pulse,
+     *  and the share of its bin in the passband power. Only with ImageProcessingSettings::rateEstimation, else 0.
+     */
+    double rateMeasureOutput;
+    double rateConfidenceOutput;
+    /*!
+     * \brief stageTimer Durations of the pipeline stages of the last frames. Callers add the stages
+     *  they run themselves, like MatToQImage.
+     */
+    StageTimer stageTimer;
 
 private:
     /*!
@@ -202,17 +246,21 @@ private:
      * \brief magnifiedBuffer (Both) Holds magnified images, that are not yet given to the GUI.
      */
     vector<cv::Mat> magnifiedBuffer;
+    /*!
+     * \brief breathExtractor (Motion magnification) Computes breathMeasureOutput from the thresholded motion.
+     */
+    BreathExtractor breathExtractor;
     /*!
      * \brief tempBuffer (Motion magnification) Holds image pyramid with the difference of two
      *  filtered images from lowpassHi & lowpassLo on each level. The upsampled pyramid is a motion
      *  image that will be added to the original image.
      */
-    vector<cv::Mat> motionPyramid;
+    LaplacePyramid motionPyramid;
     /*!
      * \brief lowpassHi (Motion magnification) Holds image pyramid of lowpassed current frame with
      *  high cutoff
      */
-    vector<cv::Mat> lowpassHi;
+    LaplacePyramid lowpassHi;
     /*!
      * \brief lowpassLo (Motion magnification) Holds image pyramid of lowpassed current frame with
      *  low cutoff
@@ -222,40 +270,174 @@ private:
      * \brief prevFrame (Motion magnification) Holds previous frame to detect motion.
      */
 
-    vector<cv::Mat> lowpassLo;
+    LaplacePyramid lowpassLo;
+    /*!
+     * \brief inputPyramid (Motion magnification) Laplace pyramid of the current frame (its luma if colored).
+     */
+    LaplacePyramid inputPyramid;
+    /*!
+     * \brief chromaPyramid (Motion magnification) Pyramids like inputPyramid, motionPyramid, lowpassHi and
+     *  lowpassLo for the Cr and Cb planes of colored frames. Unused while chromAttenuation is 0.
+     */
+    LaplacePyramid chromaPyramid;
+    LaplacePyramid chromaMotionPyramid;
+    LaplacePyramid chromaLowpassHi;
+    LaplacePyramid chromaLowpassLo;
+    /*!
+     * \brief chromaFirstLevel (Motion magnification) First level of the chroma pyramids that was processed
+     *  for the last frame, -1 if chroma was left out. Chroma lowpass pyramids restart when this changes.
+     */
+    int chromaFirstLevel;
+    /*!
+     * \brief inputFrame (Motion magnification) Current frame as float (YCrCb if colored), reused every frame.
+     *  convertedFrame holds the float BGR frame before the color conversion.
+     */
+    cv::Mat inputFrame;
+    cv::Mat convertedFrame;
+    /*!
+     * \brief motionFrame (Motion magnification) Motion image collapsed from motionPyramid, reused every frame.
+     */
+    cv::Mat motionFrame;
+    /*!
+     * \brief lumaFrame (Motion magnification) Planes of a colored frame and of its motion, reused every frame.
+     *  chromaFrame holds Cr and Cb, zeroPlane replaces the chroma motion while chroma is left out.
+     */
+    cv::Mat lumaFrame;
+    cv::Mat chromaFrame;
+    cv::Mat lumaMotion;
+    cv::Mat chromaMotion;
+    cv::Mat zeroPlane;
+    /*!
+     * \brief breathFrame (Motion magnification) 8bit motion image the breath value is detected in, reused every
+     *  frame like the other images of the detection: the blurred grays of prevFrame (breathGray, breathBlurred,
+     *  breathPrev) and of the motion (breathMotion), their difference, the thresholded mask and the drawn regions.
+     */
+    cv::Mat breathFrame;
+    cv::Mat breathGray;
+    cv::Mat breathBlurred;
+    cv::Mat breathPrev;
+    cv::Mat breathMotion;
+    cv::Mat breathDiff;
+    cv::Mat breathMask;
+    cv::Mat breathContours;
+    /*!
+     * \brief downSampledFrames (Color magnification) Holds the last 2*fps rounded to next power of 2
+     *  downsampled images, reshaped to 1 row each.
+     */
+    TemporalRingBuffer downSampledFrames;
+    /*!
+     * \brief filteredFrames (Color magnification) idealFilter result of downSampledFrames.
+     */
+    TemporalRingBuffer filteredFrames;
+    /*!
+     * \brief colorBandpass (Color magnification) Sliding DFT over downSampledFrames, used while it slides by one frame.
+     */
+    SlidingDftBandpass colorBandpass;
     /*!
-     * \brief downSampledMat (Color magnification) Holds 2*fps rounded to next power of 2
-     *  downsampled and to 1 column reshaped images.
+     * \brief colorFilterPlan (Color magnification) Bandpass mask and scratch memory of idealFilter.
      */
-    cv::Mat downSampledMat;
+    IdealFilterPlan colorFilterPlan;
+    /*!
+     * \brief leavingFrame (Color magnification) Frame of downSampledFrames that was dropped by the newest frame.
+     */
+    cv::Mat leavingFrame;
+    /*!
+     * \brief colorInput (Color magnification) Float frame the Gauss pyramid is built from, colorUpsampled the
+     *  upsampled levels of the color image but the full size one, see addGaussDelta. Reused every frame, the
+     *  window only keeps the 8bit frames.
+     */
+    cv::Mat colorInput;
+    std::vector<cv::Mat> colorUpsampled;
+    /*!
+     * \brief ratePower (Color magnification) Power of the passband bins the rate is estimated from.
+     */
+    std::vector<double> ratePower;
+    /*!
+     * \brief offlineCube (Offline color magnification) Smallest Gauss level of every frame of the video.
+     *  offlineSize and offlineChannels describe these frames, offlineMin and offlineMax the range of the
+     *  filtered cube, offlineRow holds one filtered frame.
+     */
+    std::shared_ptr<TemporalCube> offlineCube;
+    cv::Size offlineSize;
+    int offlineChannels;
+    float offlineMin;
+    float offlineMax;
+    cv::Mat offlineRow;
+    /*!
+     * \brief colorIirBandpass (Causal color magnification) Butterworth bandpass of the smallest Gauss level.
+     *  colorIirFrame holds its result, reused every frame.
+     */
+    ButterworthBandpass colorIirBandpass;
+    cv::Mat colorIirFrame;
 
     std::shared_ptr<RieszPyramid> oldPyr;
     std::shared_ptr<RieszPyramid> curPyr;
     std::shared_ptr<RieszTemporalFilter> loCutoff;
     std::shared_ptr<RieszTemporalFilter> hiCutoff;
+    /*!
+     * \brief rieszMotion (Riesz magnification) Collapsed pyramid minus the averaged frame it was built from,
+     *  added to every frame while decimating.
+     */
+    cv::Mat rieszMotion;
+    /*!
+     * \brief colorDelta (Color magnification) Amplified color image of the newest filtered frame at the smallest
+     *  Gauss level, added to every frame until the next one is filtered.
+     */
+    cv::Mat colorDelta;
+    /*!
+     * \brief decimationSum (Decimation) Sum of the frames of the current group as float, decimationCount how many
+     *  were added. decimatedFrame holds the average of the last complete group, the frame that is filtered.
+     */
+    cv::Mat decimationSum;
+    int decimationCount;
+    cv::Mat decimatedFrame;
 
     ////////////////////////
-    ///Postprocessing //////
+    ///Magnification ///////
     ////////////////////////
     /*!
-     * \brief amplifyLaplacian (Motion magnification) Amplifies a Laplacian image pyramid.
-     * \param src Source image.
-     * \param dst Destination image.
-     * \param currentLevel Level of image pyramid that is amplified.
+     * \brief colorIirMagnify Causal color magnification, a Butterworth bandpass per pixel instead of idealFilter
+     *  over a window. Every frame is magnified as soon as it arrives.
      */
-    void amplifyLaplacian(const cv::Mat &src, cv::Mat &dst, int currentLevel);
+    void colorIirMagnify();
+
+    ////////////////////////
+    ///Decimation //////////
+    ////////////////////////
     /*!
-     * \brief attenuate (Motion magnification) Attenuates the 2 last channels of a Lab-image.
-     * \param src Source image.
-     * \param dst Destination image.
+     * \brief decimationFactor Number of frames per filtered frame, ImageProcessingSettings::decimation but at least 1.
+     */
+    int decimationFactor() const;
+    /*!
+     * \brief decimate Adds a frame to the current group of decimationFactor() frames.
+     * \param frame Frame of any depth, summed as float.
+     * \param averaged Average of the group as float, only written when it is complete.
+     * \return True if frame completed the group.
+     */
+    bool decimate(const cv::Mat &frame, cv::Mat &averaged);
+    /*!
+     * \brief decimatedCutoff (Motion magnification) Weight of the new frame in a first order lowpass of
+     *  iirBandpassAmplify, such that one step at the decimated rate decays like decimationFactor() steps of cutoff.
+     */
+    double decimatedCutoff(double cutoff) const;
+
+    ////////////////////////
+    ///Postprocessing //////
+    ////////////////////////
+    /*!
+     * \brief laplaceAmplification (Motion magnification) Factor a level of the Laplacian image pyramid
+     *  is amplified with, depending on lambda of this level.
+     * \param currentLevel Level of image pyramid that is amplified.
+     * \return Amplification, 0 for the level with highest resolution and the lowpassed image.
      */
-    void attenuate(const cv::Mat &src, cv::Mat &dst);
+    float laplaceAmplification(int currentLevel);
     /*!
      * \brief amplifyGaussian (Color magnification) Amplifies a Gaussian image pyramid.
      * \param src Source image.
-     * \param dst Amplified image.
+     * \param dst Amplified image, zero where src is zeroLevel.
+     * \param zeroLevel Value of src that stands for no change, where a normalized bandpass put zero.
      */
-    void amplifyGaussian(const cv::Mat &src, cv::Mat &dst);
+    void amplifyGaussian(const cv::Mat &src, cv::Mat &dst, double zeroLevel = 0);
 
 };
 
@@ -2,6 +2,208 @@
 // From https://github.com/tbl3rd/Pyramids
 ///
 #include "RieszPyramid.h"
+// OpenCV
+#include <opencv2/core/utility.hpp>
+// C++
+#include <algorithm>
+#include <cmath>
+// SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+///////////////////////////
+// Transcendental kernels //
+///////////////////////////
+// Polynomials of cosSinX, one set per TranscendentalAccuracy. All variants evaluate the same
+// polynomials in float, so a pixel gets the same value whichever variant handles it.
+//
+// x = k*pi/2 + r with |r| <= pi/4, sin(r) = r * S(r^2), cos(r) = C(r^2).
+// Fast is the Taylor series (error 4e-5), precise the Cephes sinf/cosf polynomials
+static const int SIN_FAST_DEGREE = 2;
+static const float SIN_FAST[SIN_FAST_DEGREE+1] = { 1.0f, -1.0f/6.0f, 1.0f/120.0f };
+static const int COS_FAST_DEGREE = 3;
+static const float COS_FAST[COS_FAST_DEGREE+1] = { 1.0f, -0.5f, 1.0f/24.0f, -1.0f/720.0f };
+static const int SIN_PRECISE_DEGREE = 3;
+static const float SIN_PRECISE[SIN_PRECISE_DEGREE+1] =
+    { 1.0f, -1.6666654611e-1f, 8.3321608736e-3f, -1.9515295891e-4f };
+static const int COS_PRECISE_DEGREE = 4;
+static const float COS_PRECISE[COS_PRECISE_DEGREE+1] =
+    { 1.0f, -0.5f, 4.166664568298827e-2f, -1.388731625493765e-3f, 2.443315711809948e-5f };
+// pi/2 split in two floats (Cody-Waite), so r = x - k*pi/2 stays exact for the phases used here
+static const float PIO2_HI = 1.5707963705062866f;
+static const float PIO2_LO = -4.371139000186241e-8f;
+static const float TWO_OVER_PI = 0.63661977236758134f;
+
+// One row of cosSinX
+typedef void (*CosSinRow)(const float *x, float *cosX, float *sinX, int n);
+
+template<bool precise>
+static void cosSinRowScalar(const float *x, float *cosX, float *sinX, int n)
+{
+    const int sinDegree = precise ? SIN_PRECISE_DEGREE : SIN_FAST_DEGREE;
+    const int cosDegree = precise ? COS_PRECISE_DEGREE : COS_FAST_DEGREE;
+    const float *const sc = precise ? SIN_PRECISE : SIN_FAST;
+    const float *const cc = precise ? COS_PRECISE : COS_FAST;
+    for (int i = 0; i < n; ++i) {
+        const float k = std::nearbyint(x[i] * TWO_OVER_PI);
+        const float r = (x[i] - k*PIO2_HI) - k*PIO2_LO;
+        const float r2 = r*r;
+        float s = sc[sinDegree], c = cc[cosDegree];
+        for (int j = sinDegree-1; j >= 0; --j)
+            s = s*r2 + sc[j];
+        for (int j = cosDegree-1; j >= 0; --j)
+            c = c*r2 + cc[j];
+        s *= r;
+        // Quadrant k mod 4: odd swaps cos and sin, cos is negated in 1 and 2, sin in 2 and 3
+        const int q = static_cast<int>(k);
+        const float cq = (q & 1) ? s : c;
+        const float sq = (q & 1) ? c : s;
+        cosX[i] = ((q + 1) & 2) ? -cq : cq;
+        sinX[i] = (q & 2) ? -sq : sq;
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RVM_TRANSCENDENTAL_SSE2
+
+template<bool precise>
+static void cosSinRowSse2(const float *x, float *cosX, float *sinX, int n)
+{
+    const int sinDegree = precise ? SIN_PRECISE_DEGREE : SIN_FAST_DEGREE;
+    const int cosDegree = precise ? COS_PRECISE_DEGREE : COS_FAST_DEGREE;
+    const float *const sc = precise ? SIN_PRECISE : SIN_FAST;
+    const float *const cc = precise ? COS_PRECISE : COS_FAST;
+    const __m128 vTwoOverPi = _mm_set1_ps(TWO_OVER_PI);
+    const __m128 vPio2Hi = _mm_set1_ps(PIO2_HI), vPio2Lo = _mm_set1_ps(PIO2_LO);
+    const __m128i vOne = _mm_set1_epi32(1), vTwo = _mm_set1_epi32(2);
+    int i = 0;
+    for(; i <= n - 4; i += 4) {
+        const __m128 v = _mm_loadu_ps(x + i);
+        // Rounds to nearest like std::nearbyint
+        const __m128i k = _mm_cvtps_epi32(_mm_mul_ps(v, vTwoOverPi));
+        const __m128 kf = _mm_cvtepi32_ps(k);
+        const __m128 r = _mm_sub_ps(_mm_sub_ps(v, _mm_mul_ps(kf, vPio2Hi)), _mm_mul_ps(kf, vPio2Lo));
+        const __m128 r2 = _mm_mul_ps(r, r);
+        __m128 s = _mm_set1_ps(sc[sinDegree]), c = _mm_set1_ps(cc[cosDegree]);
+        for (int j = sinDegree-1; j >= 0; --j)
+            s = _mm_add_ps(_mm_mul_ps(s, r2), _mm_set1_ps(sc[j]));
+        for (int j = cosDegree-1; j >= 0; --j)
+            c = _mm_add_ps(_mm_mul_ps(c, r2), _mm_set1_ps(cc[j]));
+        s = _mm_mul_ps(s, r);
+
+        const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(k, vOne), vOne));
+        const __m128 cq = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+        const __m128 sq = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+        // Bit 1 of k+1 and k moved to the sign bit
+        const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(k, vOne), vTwo), 30));
+        const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(k, vTwo), 30));
+        _mm_storeu_ps(cosX + i, _mm_xor_ps(cq, cosSign));
+        _mm_storeu_ps(sinX + i, _mm_xor_ps(sq, sinSign));
+    }
+    cosSinRowScalar<precise>(x + i, cosX + i, sinX + i, n - i);
+}
+
+// 256 bit variant, compiled for AVX2 regardless of the compiler flags and only called if the CPU has it
+#if defined(__GNUC__) || defined(__clang__)
+#define RVM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RVM_TARGET_AVX2
+#endif
+
+template<bool precise>
+RVM_TARGET_AVX2
+static void cosSinRowAvx2(const float *x, float *cosX, float *sinX, int n)
+{
+    const int sinDegree = precise ? SIN_PRECISE_DEGREE : SIN_FAST_DEGREE;
+    const int cosDegree = precise ? COS_PRECISE_DEGREE : COS_FAST_DEGREE;
+    const float *const sc = precise ? SIN_PRECISE : SIN_FAST;
+    const float *const cc = precise ? COS_PRECISE : COS_FAST;
+    const __m256 vTwoOverPi = _mm256_set1_ps(TWO_OVER_PI);
+    const __m256 vPio2Hi = _mm256_set1_ps(PIO2_HI), vPio2Lo = _mm256_set1_ps(PIO2_LO);
+    const __m256i vOne = _mm256_set1_epi32(1), vTwo = _mm256_set1_epi32(2);
+    int i = 0;
+    for(; i <= n - 8; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256i k = _mm256_cvtps_epi32(_mm256_mul_ps(v, vTwoOverPi));
+        const __m256 kf = _mm256_cvtepi32_ps(k);
+        const __m256 r = _mm256_sub_ps(_mm256_sub_ps(v, _mm256_mul_ps(kf, vPio2Hi)), _mm256_mul_ps(kf, vPio2Lo));
+        const __m256 r2 = _mm256_mul_ps(r, r);
+        __m256 s = _mm256_set1_ps(sc[sinDegree]), c = _mm256_set1_ps(cc[cosDegree]);
+        for (int j = sinDegree-1; j >= 0; --j)
+            s = _mm256_add_ps(_mm256_mul_ps(s, r2), _mm256_set1_ps(sc[j]));
+        for (int j = cosDegree-1; j >= 0; --j)
+            c = _mm256_add_ps(_mm256_mul_ps(c, r2), _mm256_set1_ps(cc[j]));
+        s = _mm256_mul_ps(s, r);
+
+        const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(k, vOne), vOne));
+        const __m256 cq = _mm256_blendv_ps(c, s, swap);
+        const __m256 sq = _mm256_blendv_ps(s, c, swap);
+        const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(k, vOne), vTwo), 30));
+        const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(k, vTwo), 30));
+        _mm256_storeu_ps(cosX + i, _mm256_xor_ps(cq, cosSign));
+        _mm256_storeu_ps(sinX + i, _mm256_xor_ps(sq, sinSign));
+    }
+    cosSinRowSse2<precise>(x + i, cosX + i, sinX + i, n - i);
+}
+#endif
+
+// AArch64 only: ARMv7 NEON has no round to nearest conversion
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define RVM_TRANSCENDENTAL_NEON
+
+template<bool precise>
+static void cosSinRowNeon(const float *x, float *cosX, float *sinX, int n)
+{
+    const int sinDegree = precise ? SIN_PRECISE_DEGREE : SIN_FAST_DEGREE;
+    const int cosDegree = precise ? COS_PRECISE_DEGREE : COS_FAST_DEGREE;
+    const float *const sc = precise ? SIN_PRECISE : SIN_FAST;
+    const float *const cc = precise ? COS_PRECISE : COS_FAST;
+    const float32x4_t vTwoOverPi = vdupq_n_f32(TWO_OVER_PI);
+    const float32x4_t vPio2Hi = vdupq_n_f32(PIO2_HI), vPio2Lo = vdupq_n_f32(PIO2_LO);
+    const int32x4_t vOne = vdupq_n_s32(1), vTwo = vdupq_n_s32(2);
+    int i = 0;
+    for(; i <= n - 4; i += 4) {
+        const float32x4_t v = vld1q_f32(x + i);
+        const int32x4_t k = vcvtnq_s32_f32(vmulq_f32(v, vTwoOverPi));
+        const float32x4_t kf = vcvtq_f32_s32(k);
+        const float32x4_t r = vsubq_f32(vsubq_f32(v, vmulq_f32(kf, vPio2Hi)), vmulq_f32(kf, vPio2Lo));
+        const float32x4_t r2 = vmulq_f32(r, r);
+        float32x4_t s = vdupq_n_f32(sc[sinDegree]), c = vdupq_n_f32(cc[cosDegree]);
+        for (int j = sinDegree-1; j >= 0; --j)
+            s = vaddq_f32(vmulq_f32(s, r2), vdupq_n_f32(sc[j]));
+        for (int j = cosDegree-1; j >= 0; --j)
+            c = vaddq_f32(vmulq_f32(c, r2), vdupq_n_f32(cc[j]));
+        s = vmulq_f32(s, r);
+
+        const uint32x4_t swap = vceqq_s32(vandq_s32(k, vOne), vOne);
+        const float32x4_t cq = vbslq_f32(swap, s, c);
+        const float32x4_t sq = vbslq_f32(swap, c, s);
+        const uint32x4_t cosSign = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(vaddq_s32(k, vOne), vTwo)), 30);
+        const uint32x4_t sinSign = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(k, vTwo)), 30);
+        vst1q_f32(cosX + i, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(cq), cosSign)));
+        vst1q_f32(sinX + i, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sq), sinSign)));
+    }
+    cosSinRowScalar<precise>(x + i, cosX + i, sinX + i, n - i);
+}
+#endif
+
+template<bool precise>
+static CosSinRow selectCosSinRow()
+{
+#if defined(RVM_TRANSCENDENTAL_SSE2)
+    if(cv::checkHardwareSupport(CV_CPU_AVX2))
+        return cosSinRowAvx2<precise>;
+    return cosSinRowSse2<precise>;
+#elif defined(RVM_TRANSCENDENTAL_NEON)
+    return cosSinRowNeon<precise>;
+#else
+    return cosSinRowScalar<precise>;
+#endif
+}
 
 /////////////////////
 // Riesz Pyr Level //
@@ -15,6 +217,7 @@ RieszPyramidLevel::RieszPyramidLevel(const RieszPyramidLevel& other)
     imag ( other.itsR     ) .copyTo( imag ( itsR     ));
     cos  ( other.itsPhase ) .copyTo( cos  ( itsPhase ));
     sin  ( other.itsPhase ) .copyTo( sin  ( itsPhase ));
+           other.itsMagnified.copyTo(   itsMagnified);
 }
 RieszPyramidLevel& RieszPyramidLevel::operator=(const RieszPyramidLevel& other)
 {
@@ -25,6 +228,7 @@ RieszPyramidLevel& RieszPyramidLevel::operator=(const RieszPyramidLevel& other)
             imag ( other.itsR     ) .copyTo( imag ( itsR     ));
             cos  ( other.itsPhase ) .copyTo( cos  ( itsPhase ));
             sin  ( other.itsPhase ) .copyTo( sin  ( itsPhase ));
+                   other.itsMagnified.copyTo(   itsMagnified);
     }
 
     return *this;
@@ -40,63 +244,78 @@ void RieszPyramidLevel::build(const cv::Mat &octave) {
     cv::filter2D(itsLp, imag(itsR), itsLp.depth(), imagK, cv::Point(-1,-1), 0, cv::BORDER_REFLECT_101);
 }
 
-// Write into result the element-wise inverse cosine of X.
-void RieszPyramidLevel::arcCosX(const cv::Mat &X, cv::Mat &result) {
-    assert(X.isContinuous() && result.isContinuous());
-    const float *const pX =      X.ptr<float>(0);
-    float *const pResult  = result.ptr<float>(0);
-    const int count = X.rows * X.cols;
-
-    for (int i = 0; i < count; ++i)
-    {
-        pResult[i] = acos(pX[i]);
-    }
+void RieszPyramidLevel::swapFrame(RieszPyramidLevel &other) {
+    std::swap(itsLp, other.itsLp);
+    std::swap(itsR, other.itsR);
+    std::swap(itsPhase, other.itsPhase);
 }
 
 // This calculates movements separated by edges.
 // Cos (itsPhase.first) are vertical edges
 // Sin (itsPhase.second) are horizontal edges
 void RieszPyramidLevel::unwrapOrientPhase(const RieszPyramidLevel &prior) {
-    cv::Mat temp1
-        =      itsLp.mul(prior.itsLp)
-        + real(itsR).mul(real(prior.itsR))
-        + imag(itsR).mul(imag(prior.itsR));
-    cv::Mat temp2
-        =       real(itsR).mul(prior.itsLp)
-        - real(prior.itsR).mul(itsLp);
-    cv::Mat temp3
-        =       imag(itsR).mul(prior.itsLp)
-        - imag(prior.itsR).mul(itsLp);
-    cv::Mat tempP  = temp2.mul(temp2) + temp3.mul(temp3);
-    cv::Mat phi    = tempP            + temp1.mul(temp1);
-    cv::sqrt(phi, phi);
-    cv::divide(temp1, phi, temp1);
-    cv::patchNaNs(temp1, 0.0);
-    arcCosX(temp1, phi);
-    cv::sqrt(tempP, tempP);
-    cv::divide(temp2, tempP, temp2);
-    cv::patchNaNs(temp2, 0.0);
-    cv::divide(temp3, tempP, temp3);
-    cv::patchNaNs(temp3, 0.0);
-    cos(itsPhase) = temp2.mul(phi);
-    sin(itsPhase) = temp3.mul(phi);
+    CV_Assert(itsLp.type() == CV_32FC1 && prior.itsLp.size() == itsLp.size());
+    const int cols = itsLp.cols;
+    cos(itsPhase).create(itsLp.size(), CV_32F);
+    sin(itsPhase).create(itsLp.size(), CV_32F);
+    // One row of the real part of the quaternion product, the norm of its vector part and the angle between them
+    cv::Mat realPart(1, cols, CV_32F), vectorNorm(1, cols, CV_32F), angle(1, cols, CV_32F);
+    float *const pReal  = realPart.ptr<float>(0);
+    float *const pNorm  = vectorNorm.ptr<float>(0);
+    const float *const pAngle = angle.ptr<float>(0);
+
+    for (int y = 0; y < itsLp.rows; ++y) {
+        const float *const pLp      = itsLp.ptr<float>(y);
+        const float *const pR1      = real(itsR).ptr<float>(y);
+        const float *const pR2      = imag(itsR).ptr<float>(y);
+        const float *const pPriorLp = prior.itsLp.ptr<float>(y);
+        const float *const pPriorR1 = real(prior.itsR).ptr<float>(y);
+        const float *const pPriorR2 = imag(prior.itsR).ptr<float>(y);
+        float *const pCos = cos(itsPhase).ptr<float>(y);
+        float *const pSin = sin(itsPhase).ptr<float>(y);
+
+        // Vector part is kept in the output until the angle is known
+        for (int x = 0; x < cols; ++x) {
+            const float q1 = pR1[x]*pPriorLp[x] - pPriorR1[x]*pLp[x];
+            const float q2 = pR2[x]*pPriorLp[x] - pPriorR2[x]*pLp[x];
+            pReal[x] = pLp[x]*pPriorLp[x] + pR1[x]*pPriorR1[x] + pR2[x]*pPriorR2[x];
+            pNorm[x] = std::sqrt(q1*q1 + q2*q2);
+            pCos[x] = q1;
+            pSin[x] = q2;
+        }
+
+        // acos(real / |q|) is the angle of (real, norm), OpenCV's vectorized atan2. No division by |q|,
+        // and rounding can't push the argument out of [-1, 1]
+        cv::phase(realPart, vectorNorm, angle);
+
+        // Without a vector part (or with NaN) there is no orientation, the phase is 0 like patchNaNs made it
+        for (int x = 0; x < cols; ++x) {
+            const float scale = pNorm[x] > 0.0f ? pAngle[x] / pNorm[x] : 0.0f;
+            pCos[x] = pNorm[x] > 0.0f ? pCos[x] * scale : 0.0f;
+            pSin[x] = pNorm[x] > 0.0f ? pSin[x] * scale : 0.0f;
+        }
+    }
 }
 
 // Write into result the element-wise cosines and sines of X.
-void RieszPyramidLevel::cosSinX(const cv::Mat &X, CompExpMat &result)
+void RieszPyramidLevel::cosSinX(const cv::Mat &X, CompExpMat &result, TranscendentalAccuracy accuracy)
 {
-    assert(X.isContinuous());
-    cos(result) = cv::Mat::zeros(X.size(), CV_32F);
-    sin(result) = cv::Mat::zeros(X.size(), CV_32F);
-    assert(cos(result).isContinuous() && sin(result).isContinuous());
-    const float *const pX =           X.ptr<float>(0);
-    float *const pCosX    = cos(result).ptr<float>(0);
-    float *const pSinX    = sin(result).ptr<float>(0);
-    const int count = X.rows * X.cols;
-    for (int i = 0; i < count; ++i) {
-        pCosX[i] = cos(pX[i]);
-        pSinX[i] = sin(pX[i]);
+    CV_Assert(X.type() == CV_32FC1);
+    cos(result).create(X.size(), CV_32F);
+    sin(result).create(X.size(), CV_32F);
+
+    static const CosSinRow fastRow = selectCosSinRow<false>();
+    static const CosSinRow preciseRow = selectCosSinRow<true>();
+    const CosSinRow row = (accuracy == TRANSCENDENTAL_PRECISE) ? preciseRow : fastRow;
+
+    int rows = X.rows;
+    int n = X.cols;
+    if(X.isContinuous() && cos(result).isContinuous() && sin(result).isContinuous()) {
+        n *= rows;
+        rows = 1;
     }
+    for (int y = 0; y < rows; ++y)
+        row(X.ptr<float>(y), cos(result).ptr<float>(y), sin(result).ptr<float>(y), n);
 }
 
 cv::Mat RieszPyramidLevel::rms() {
@@ -127,7 +346,7 @@ void RieszPyramidLevel::normalize(CompExpMat &result) {
 
 // Multipy the phase difference in this level by alpha but only up to
 // some ceiling threshold.
-void RieszPyramidLevel::amplify(double alpha, double threshold) {
+void RieszPyramidLevel::amplify(double alpha, double threshold, TranscendentalAccuracy accuracy) {
     CompExpMat temp;
     normalize(temp);
 
@@ -136,18 +355,20 @@ void RieszPyramidLevel::amplify(double alpha, double threshold) {
     cv::Mat MagV2 = MagV * alpha;
     cv::threshold(MagV2, MagV2, threshold, 0, cv::THRESH_TRUNC);
     CompExpMat phaseDiff;
-    cosSinX(MagV2, phaseDiff);
+    cosSinX(MagV2, phaseDiff, accuracy);
     cv::Mat pair = real(itsR).mul(cos(temp)) + imag(itsR).mul(sin(temp));
     cv::divide(pair, MagV, pair);
     cv::patchNaNs(pair, 0.0);
-    itsLp = itsLp.mul(cos(phaseDiff)) - pair.mul(sin(phaseDiff));
+    itsMagnified = itsLp.mul(cos(phaseDiff)) - pair.mul(sin(phaseDiff));
 }
 
 
 /////////////////
 // Riesz Pyr  //
 ////////////////
-RieszPyramid::RieszPyramid()
+RieszPyramid::RieszPyramid() :
+    fast(false),
+    amplified(false)
 {
     // Init low and highpass filter for pyramid construction/collapse
     this->lowPassFilter = (cv::Mat_<float>(9,9)<< -0.0001,   -0.0007,  -0.0023,  -0.0046,  -0.0057,  -0.0046,  -0.0023,  -0.0007,  -0.0001,
@@ -169,14 +390,18 @@ RieszPyramid::RieszPyramid()
                                              0.0011,    0.0059,   0.0151,   0.0249,   0.0292,   0.0249,   0.0151,   0.0059,   0.0011,
                                              0.0003,    0.0020,   0.0059,   0.0103,   0.0123,   0.0103,   0.0059,   0.0020,   0.0003,
                                              0.0000,    0.0003,   0.0011,   0.0022,   0.0027,   0.0022,   0.0011,   0.0003,   0.0000);
+    initScaledFilters();
 }
 RieszPyramid::~RieszPyramid() { }
 RieszPyramid::RieszPyramid(const RieszPyramid& other)
 {
     this->numLevels = other.numLevels;
+    this->fast = other.fast;
+    this->amplified = other.amplified;
     this->pyrLevels.resize(other.pyrLevels.size());
     other.lowPassFilter.copyTo(this->lowPassFilter);
     other.highPassFilter.copyTo(this->highPassFilter);
+    initScaledFilters();
     for (int i = 0; i < this->numLevels; ++i)
     {
         this->pyrLevels[i] = other.pyrLevels[i];
@@ -187,9 +412,12 @@ RieszPyramid& RieszPyramid::operator=(const RieszPyramid& other)
     if(this != &other)
     {
         this->numLevels = other.numLevels;
+        this->fast = other.fast;
+        this->amplified = other.amplified;
         this->pyrLevels.resize(other.pyrLevels.size());
         other.lowPassFilter.copyTo(this->lowPassFilter);
         other.highPassFilter.copyTo(this->highPassFilter);
+        initScaledFilters();
         for (int i = 0; i < this->numLevels; ++i)
         {
             this->pyrLevels[i] = other.pyrLevels[i];
@@ -199,10 +427,11 @@ RieszPyramid& RieszPyramid::operator=(const RieszPyramid& other)
     return *this;
 }
 
-void RieszPyramid::init(cv::Mat &frame, int levels)
+void RieszPyramid::init(cv::Mat &frame, int levels, bool fast)
 {
     this->pyrLevels.resize(levels);
     numLevels = levels;
+    this->fast = fast;
     // Build pyramid from given frame
     buildPyramid(frame);
     for (int i = 0; i < this->numLevels; ++i) {
@@ -221,17 +450,27 @@ void RieszPyramid::init(cv::Mat &frame, int levels)
 void RieszPyramid::buildPyramid(const cv::Mat &frame) {
     const int max = this->numLevels-1;
     cv::Mat octave = frame;
+    amplified = false;
 
     for (int i = 0; i < max; ++i) {
-        cv::Mat hp, lp, down;
-
-        // Highpass undergoes riesz transform
-        cv::filter2D(octave, hp, CV_32F, highPassFilter, cv::Point(-1,-1), 0, cv::BORDER_REFLECT_101);
-        pyrLevels[i].build(hp);
+        cv::Mat hp, down;
+
+        if(fast) {
+            // Laplacian level: separable 5x5 binomial, pyrDown only computes the pixels it keeps
+            cv::pyrDown(octave, down);
+            cv::pyrUp(down, hp, octave.size());
+            cv::subtract(octave, hp, hp);
+            pyrLevels[i].build(hp);
+        }
+        else {
+            // Highpass undergoes riesz transform
+            cv::filter2D(octave, hp, CV_32F, highPassFilter, cv::Point(-1,-1), 0, cv::BORDER_REFLECT_101);
+            pyrLevels[i].build(hp);
 
-        // Lowpass is passed onto the next level
-        cv::filter2D(octave, lp, CV_32F, 2.0*lowPassFilter, cv::Point(-1,-1), 0, cv::BORDER_REFLECT_101);
-        octave = subsample(lp);
+            // Lowpass is passed onto the next level
+            lowpassDecimate(octave, down);
+        }
+        octave = down;
     }
 
     pyrLevels[max].build(octave);
@@ -247,85 +486,147 @@ void RieszPyramid::unwrapOrientPhase(const RieszPyramid &prior) {
 }
 
 // Amplify motion by alpha up to threshold using filtered phase data.
-void RieszPyramid::amplify(double alpha, double threshold)
+void RieszPyramid::amplify(double alpha, double threshold, TranscendentalAccuracy accuracy)
 {
     for(int i = this->numLevels-1; i >= 0; i--) {
-        pyrLevels[i].amplify(alpha, threshold);
+        pyrLevels[i].amplify(alpha, threshold, accuracy);
     }
+    amplified = true;
 }
 
-const cv::Mat RieszPyramid::subsample(cv::Mat &img) {
-    // accept only grayscale float type matrices
-    CV_Assert(img.depth() == CV_32F);
-    CV_Assert(img.channels() == 1);
-    CV_Assert(img.isContinuous());
-
-    int nRowsBig = img.rows;
-    int nColsBig = img.cols;
-
-    cv::Mat tmp = cv::Mat::zeros(img.rows/2 + (img.rows%2), img.cols/2 + (img.cols%2), CV_32F);
-
-    float *p = img.ptr<float>(0);
-    float *tmp_p = tmp.ptr<float>(0);
-
-    for (int y = 0; y < nRowsBig; y += 2) {
-        for (int x = 0; x < nColsBig; x += 2) {
-            int subIdx = x/2 + (y/2)*tmp.cols;
-            int bigIdx = x + y*nColsBig;
+void RieszPyramid::swapFrame(RieszPyramid &prior)
+{
+    CV_Assert(prior.pyrLevels.size() == pyrLevels.size());
+    for (size_type i = 0; i < pyrLevels.size(); ++i)
+        pyrLevels[i].swapFrame(prior.pyrLevels[i]);
+}
 
-            tmp_p[subIdx] = p[bigIdx];
+void RieszPyramid::initScaledFilters()
+{
+    scaledLowPassFilter = 2.0*lowPassFilter;
+    // lowPassPhases[2*s+t](p,q) = scaledLowPassFilter(2p+s, 2q+t)
+    lowPassPhases.resize(4);
+    for (int s = 0; s < 2; ++s) {
+        for (int t = 0; t < 2; ++t) {
+            cv::Mat &phase = lowPassPhases[2*s+t];
+            phase.create((scaledLowPassFilter.rows-s+1)/2, (scaledLowPassFilter.cols-t+1)/2, CV_32F);
+            for (int p = 0; p < phase.rows; ++p)
+                for (int q = 0; q < phase.cols; ++q)
+                    phase.at<float>(p, q) = scaledLowPassFilter.at<float>(2*p+s, 2*q+t);
         }
     }
-
-    return tmp.clone();
 }
 
-const cv::Mat RieszPyramid::injectZerosEven(cv::Mat &img) {
+void RieszPyramid::lowpassDecimate(const cv::Mat &src, cv::Mat &dst)
+{
     // accept only grayscale float type matrices
-    CV_Assert(img.depth() == CV_32F);
-    CV_Assert(img.channels() == 1);
-    CV_Assert(img.isContinuous());
-
-    int nRows = img.rows;
-    int nCols = img.cols;
-
-    cv::Mat tmp = cv::Mat::zeros(nRows, nCols, CV_32F);
-
-    float *p = img.ptr<float>(0);
-    float *tmp_p = tmp.ptr<float>(0);
+    CV_Assert(src.type() == CV_32FC1);
+    const int radius = scaledLowPassFilter.rows / 2;
+    const cv::Size dstSize((src.cols+1)/2, (src.rows+1)/2);
+
+    // Same borders as filter2D with BORDER_REFLECT_101 on the whole image, then
+    // dst(i,j) = sum k(a,b) * padded(2i+a, 2j+b). Split by the parity (s,t) of (a,b), every
+    // phase paddedPhase(u,v) = padded(2u+s, 2v+t) is correlated with the taps of that parity
+    cv::copyMakeBorder(src, padded, radius, radius, radius, radius, cv::BORDER_REFLECT_101);
+    paddedPhases.resize(4);
+    for (int s = 0; s < 2; ++s) {
+        for (int t = 0; t < 2; ++t) {
+            cv::Mat &phase = paddedPhases[2*s+t];
+            phase.create((padded.rows-s+1)/2, (padded.cols-t+1)/2, CV_32F);
+            for (int y = 0; y < phase.rows; ++y) {
+                const float *in = padded.ptr<float>(2*y+s) + t;
+                float *out = phase.ptr<float>(y);
+                for (int x = 0; x < phase.cols; ++x)
+                    out[x] = in[2*x];
+            }
+
+            // Anchored top left, the taps of an output pixel lie inside the phase, so the border mode is never used
+            const cv::Mat roi = phase(cv::Rect(cv::Point(0, 0), dstSize));
+            if(s == 0 && t == 0) {
+                dst.create(dstSize, CV_32F);
+                cv::filter2D(roi, dst, CV_32F, lowPassPhases[0], cv::Point(0,0), 0, cv::BORDER_REFLECT_101);
+            }
+            else {
+                cv::filter2D(roi, filtered, CV_32F, lowPassPhases[2*s+t], cv::Point(0,0), 0, cv::BORDER_REFLECT_101);
+                dst += filtered;
+            }
+        }
+    }
+}
 
-    for (int y = 0; y < nRows; y += 2) {
-        for (int x = 0; x < nCols; x += 2) {
+void RieszPyramid::upsampleAdd(const cv::Mat &src, const cv::Mat &addend, cv::Mat &dst)
+{
+    // accept only grayscale float type matrices
+    CV_Assert(src.type() == CV_32FC1 && addend.type() == CV_32FC1);
+    // Source pixels a 9x9 window of the upsampled image reaches beyond the edge
+    const int border = (scaledLowPassFilter.rows/2 + 1) / 2;
+
+    // The upsampled image holds src on even pixels and zeros in between and is filtered with BORDER_REFLECT_101.
+    // Reflecting keeps the parity, so the source pixel behind the edge is the one its even upsampled pixel
+    // reflects onto. Behind an even sized edge that repeats the last pixel, unlike BORDER_REFLECT_101 on src
+    padded.create(src.rows + 2*border, src.cols + 2*border, CV_32F);
+    paddedCols.resize(padded.cols);
+    for (int x = 0; x < padded.cols; ++x)
+        paddedCols[x] = cv::borderInterpolate(2*(x-border), addend.cols, cv::BORDER_REFLECT_101) / 2;
+    for (int y = 0; y < padded.rows; ++y) {
+        const float *in = src.ptr<float>(cv::borderInterpolate(2*(y-border), addend.rows, cv::BORDER_REFLECT_101) / 2);
+        float *out = padded.ptr<float>(y);
+        for (int x = 0; x < padded.cols; ++x)
+            out[x] = in[paddedCols[x]];
+    }
 
-            int idx = x + y*nCols;
-            tmp_p[idx] = p[idx];
+    // dst(2i+s, 2j+t) = sum lowPassPhases[2*s+t](c,d) * padded(i+s+c, j+t+d) + addend(2i+s, 2j+t)
+    dst.create(addend.size(), CV_32F);
+    for (int s = 0; s < 2; ++s) {
+        for (int t = 0; t < 2; ++t) {
+            const cv::Size phaseSize((dst.cols-t+1)/2, (dst.rows-s+1)/2);
+            if(phaseSize.area() == 0)
+                continue;
+            // Anchored top left, the taps of an output pixel lie inside padded, so the border mode is never used
+            cv::filter2D(padded(cv::Rect(cv::Point(t, s), phaseSize)), filtered, CV_32F, lowPassPhases[2*s+t],
+                         cv::Point(0,0), 0, cv::BORDER_REFLECT_101);
+            for (int y = 0; y < phaseSize.height; ++y) {
+                const float *in = filtered.ptr<float>(y);
+                const float *add = addend.ptr<float>(2*y+s) + t;
+                float *out = dst.ptr<float>(2*y+s) + t;
+                for (int x = 0; x < phaseSize.width; ++x)
+                    out[2*x] = in[x] + add[2*x];
+            }
         }
     }
-
-    return tmp.clone();
 }
 
 // Return the frame resulting from the collapse of this pyramid.
 //
 const cv::Mat RieszPyramid::collapsePyramid() {
     const int count = pyrLevels.size() - 1;
-    cv::Mat result = pyrLevels[count].itsLp;
+    // Levels with the amplified phase if there are any
+    auto octaveOf = [this](int i) -> const cv::Mat & {
+        return amplified ? pyrLevels[i].itsMagnified : pyrLevels[i].itsLp;
+    };
+    cv::Mat result = octaveOf(count);
+    collapsed.resize(std::max(count, 0));
+
+    // Laplacian levels add up to the image
+    if(fast) {
+        for (int i = count - 1; i >= 0; --i) {
+            cv::pyrUp(result, collapsed[i], octaveOf(i).size());
+            cv::add(collapsed[i], octaveOf(i), collapsed[i]);
+            result = collapsed[i];
+        }
+        return result;
+    }
 
     for (int i = count - 1; i >= 0; --i) {
-       const cv::Mat &octave = pyrLevels[i].itsLp;
-        cv::Mat lp, hp, up, up_zero;
-
-        // Upsample with image without interpolation (= inject zeros on 3 of 4 pixels in every 4x4 neighborhood)
-        // Filter with lowpass after upsampling (2.0*lpFilter) to make up for energy lost during upsampling
-        cv::resize(result, up, octave.size(), 0, 0, cv::INTER_NEAREST);
-        up_zero = injectZerosEven(up);
-        cv::filter2D(up_zero, lp, CV_32F, 2.0*lowPassFilter, cv::Point(-1,-1), 0, cv::BORDER_REFLECT_101);
+        const cv::Mat &octave = octaveOf(i);
 
         // Highpass on current levels img
-        cv::filter2D(octave, hp, CV_32F, highPassFilter, cv::Point(-1,-1), 0, cv::BORDER_REFLECT_101);
+        cv::filter2D(octave, highpass, CV_32F, highPassFilter, cv::Point(-1,-1), 0, cv::BORDER_REFLECT_101);
 
-        // Reconstruct image adding LP and HP
-        result = lp + hp;
+        // Reconstruct image adding LP and HP. The lowpass (2.0*lpFilter) makes up for the energy lost by
+        // upsampling with zeros on 3 of 4 pixels
+        upsampleAdd(result, highpass, collapsed[i]);
+        result = collapsed[i];
     }
     return result;
 }
@@ -10,6 +10,12 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 
+// Accuracy of cosSinX
+enum TranscendentalAccuracy {
+    TRANSCENDENTAL_FAST,        // error about 1e-4, plenty for amplifying phases
+    TRANSCENDENTAL_PRECISE      // error close to float precision
+};
+
 class RieszPyramidLevel {
 
 public:
@@ -23,12 +29,14 @@ public:
     CompExpMat itsPhase;               // the amplified result
     CompExpMat itsRealPass;            // per-level filter state maintained
     CompExpMat itsImagPass;            // across frames
+    cv::Mat itsMagnified;              // itsLp with the amplified phase
 
     // Octave is a laplace pyr level. This applies x and yKernel
     void build(const cv::Mat &octave);
 
-    // Write into result the element-wise inverse cosine of X.
-    static void arcCosX(const cv::Mat &X, cv::Mat &result);
+    // Exchange the frame (itsLp, itsR, itsPhase) with other without copying.
+    // The filter state itsRealPass/itsImagPass stays.
+    void swapFrame(RieszPyramidLevel &other);
 
     // This calculates movements separated by edges.
     // Cos (itsPhase.first) are vertical edges
@@ -36,7 +44,9 @@ public:
     void unwrapOrientPhase(const RieszPyramidLevel &prior);
 
     // Write into result the element-wise cosines and sines of X.
-    static void cosSinX(const cv::Mat &X, CompExpMat &result);
+    // Vectorized polynomial, the parts of result are reused if they have the size of X.
+    static void cosSinX(const cv::Mat &X, CompExpMat &result,
+                        TranscendentalAccuracy accuracy = TRANSCENDENTAL_PRECISE);
 
     // Used to get amplitude. Square sin&cos of phase, add lowpass, square resulting mat
     cv::Mat rms();
@@ -45,8 +55,8 @@ public:
     void normalize(CompExpMat &result);
 
     // Multipy the phase difference in this level by alpha but only up to
-    // some ceiling threshold.
-    void amplify(double alpha, double threshold);
+    // some ceiling threshold. Writes itsMagnified, itsLp is kept.
+    void amplify(double alpha, double threshold, TranscendentalAccuracy accuracy = TRANSCENDENTAL_FAST);
 };
 
 
@@ -67,8 +77,9 @@ public:
     // Vector of Pyramid Levels
     std::vector<RieszPyramidLevel> pyrLevels;
 
-    // Initialize filter and levels
-    void init(cv::Mat &frame, int levels);
+    // Initialize filter and levels. fast builds the levels from a Laplacian pyramid (pyrDown/pyrUp)
+    // instead of the 9x9 filters, the approximation the Riesz pyramid paper proposes for speed
+    void init(cv::Mat &frame, int levels, bool fast = false);
 
     // This builds a Riesz pyramid
     void buildPyramid(const cv::Mat &frame);
@@ -81,18 +92,43 @@ public:
     void unwrapOrientPhase(const RieszPyramid &prior);
 
     // Amplify motion by alpha up to threshold using filtered phase data.
-    void amplify(double alpha, double threshold);
+    // The cosine and sine of the amplified phase are TRANSCENDENTAL_FAST by default.
+    // collapsePyramid returns the amplified frame until the next buildPyramid.
+    void amplify(double alpha, double threshold, TranscendentalAccuracy accuracy = TRANSCENDENTAL_FAST);
+
+    // Make this frame the prior of the next one: swaps the frame of every level with prior's instead
+    // of copying it. The temporal filter state and the amplified levels stay in this pyramid.
+    void swapFrame(RieszPyramid &prior);
 
 private:
+    // Laplacian pyramid instead of the 9x9 filters
+    bool fast;
+    // amplify was called since buildPyramid, collapse the itsMagnified levels
+    bool amplified;
     // 9x9 Lowpass and Highpass filter for pyramid construction
     // Used before phase unwrapping
     cv::Mat lowPassFilter;
     cv::Mat highPassFilter;
-    // Neeed to collapse te Pyramid.
-    // Upsample without interpolation
-    const cv::Mat injectZerosEven(cv::Mat &img);
-    // Subsample image without interpolation
-    const cv::Mat subsample(cv::Mat &img);
+    // 2.0*lowPassFilter, the lowpass with the gain of subsampling and upsampling
+    cv::Mat scaledLowPassFilter;
+    // Taps of scaledLowPassFilter with even/odd row and column, index 2*rowParity+colParity
+    std::vector<cv::Mat> lowPassPhases;
+    // Scratch memory of lowpassDecimate and upsampleAdd
+    cv::Mat padded;
+    std::vector<cv::Mat> paddedPhases;
+    cv::Mat filtered;
+    std::vector<int> paddedCols;
+    // Images collapsePyramid reconstructs on every level and the highpass added there, kept between frames
+    std::vector<cv::Mat> collapsed;
+    cv::Mat highpass;
+    // Derives scaledLowPassFilter and lowPassPhases from lowPassFilter
+    void initScaledFilters();
+    // Lowpass with scaledLowPassFilter and subsample, computed by polyphase decimation:
+    // only the pixels that are kept are filtered
+    void lowpassDecimate(const cv::Mat &src, cv::Mat &dst);
+    // Upsample src to the size of addend, lowpass with scaledLowPassFilter and add addend, computed by
+    // polyphase interpolation: every output phase is filtered only with the taps that hit source pixels
+    void upsampleAdd(const cv::Mat &src, const cv::Mat &addend, cv::Mat &dst);
 };
 
 #endif // RIESZPYRAMID_H
@@ -23,6 +23,8 @@
 /************************************************************************************/
 
 #include "main/magnification/SpatialFilter.h"
+// C++
+#include <algorithm>
 //using namespace cv;
 ////////////////////////
 /// Downsampling ///////
@@ -145,6 +147,55 @@ void buildImgFromGaussPyr(const cv::Mat &pyr, const int levels, cv::Mat &dst, cv
     currentLevel.copyTo(dst);
 }
 
+void addGaussDelta(const cv::Mat &delta, const int levels, const cv::Mat &frame, cv::Mat &dst, vector<cv::Mat> &scratch)
+{
+    CV_Assert(delta.depth() == CV_32F && frame.depth() == CV_8U && delta.channels() == frame.channels());
+    const int cn = frame.channels();
+    const cv::Size size = frame.size();
+
+    // All steps but the last on the small images
+    scratch.resize(std::max(levels-1, 0));
+    cv::Mat currentLevel = delta;
+    for (int level = 0; level < levels-1; ++level) {
+        pyrUp(currentLevel, scratch[level]);
+        currentLevel = scratch[level];
+    }
+
+    // Source columns and weight of every destination column, pixel centers aligned like resize with INTER_LINEAR
+    const int srcCols = currentLevel.cols, srcRows = currentLevel.rows;
+    vector<int> xLeft(size.width), xRight(size.width);
+    vector<float> xWeight(size.width);
+    const float scaleX = static_cast<float>(srcCols) / size.width;
+    for (int x = 0; x < size.width; ++x) {
+        const float fx = std::max((x + 0.5f) * scaleX - 0.5f, 0.f);
+        const int left = std::min(static_cast<int>(fx), srcCols-1);
+        xLeft[x] = left * cn;
+        xRight[x] = std::min(left+1, srcCols-1) * cn;
+        xWeight[x] = fx - left;
+    }
+
+    dst.create(size, frame.type());
+    const float scaleY = static_cast<float>(srcRows) / size.height;
+    for (int y = 0; y < size.height; ++y) {
+        const float fy = std::max((y + 0.5f) * scaleY - 0.5f, 0.f);
+        const int top = std::min(static_cast<int>(fy), srcRows-1);
+        const float wy = fy - top;
+        const float *rowTop = currentLevel.ptr<float>(top);
+        const float *rowBottom = currentLevel.ptr<float>(std::min(top+1, srcRows-1));
+        const uchar *in = frame.ptr<uchar>(y);
+        uchar *out = dst.ptr<uchar>(y);
+        for (int x = 0; x < size.width; ++x) {
+            const int l = xLeft[x], r = xRight[x];
+            const float wx = xWeight[x];
+            for (int c = 0; c < cn; ++c) {
+                const float upper = rowTop[l+c] + wx * (rowTop[r+c] - rowTop[l+c]);
+                const float lower = rowBottom[l+c] + wx * (rowBottom[r+c] - rowBottom[l+c]);
+                out[x*cn+c] = cv::saturate_cast<uchar>(in[x*cn+c] + upper + wy * (lower - upper));
+            }
+        }
+    }
+}
+
 void buildImgFromLaplacePyr(const vector<cv::Mat> &pyr, const int levels, cv::Mat &dst)
 {
     cv::Mat currentLevel = pyr[levels];
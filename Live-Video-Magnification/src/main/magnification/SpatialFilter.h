@@ -84,6 +84,18 @@ void buildWaveletPyrFromImg(const cv::Mat &img, const int levels, vector< vector
  * \param size Destination size of upsampled image.
  */
 void buildImgFromGaussPyr(const cv::Mat &pyr, const int levels, cv::Mat &dst, cv::Size size);
+/*!
+ * \brief addGaussDelta Reconstructs a delta image from the smallest level of a Gauss Pyramid and adds it to
+ *  an 8bit frame. The first levels-1 steps are pyrUps like buildImgFromGaussPyr, the last one interpolates
+ *  bilinearly straight to the size of the frame and adds to it with saturation in the same pass, so the full
+ *  size delta is never stored.
+ * \param delta Smallest level, 32bit float with the channels of frame.
+ * \param levels Number of times the delta is upsampled.
+ * \param frame 8bit frame the delta is added to.
+ * \param dst Destination Mat, size and type of frame. May be frame itself.
+ * \param scratch Upsampled levels but the last, kept between calls.
+ */
+void addGaussDelta(const cv::Mat &delta, const int levels, const cv::Mat &frame, cv::Mat &dst, vector<cv::Mat> &scratch);
 /*!
  * \brief buildImgFromLaplacePyr Reconstructs an image from a given Laplace Pyramid.
  * \param pyr Vector that holds the image levels of the Pyramid.
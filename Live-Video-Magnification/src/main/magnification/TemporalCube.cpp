@@ -0,0 +1,139 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->TemporalCube.cpp                                   */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+
+#include "main/magnification/TemporalCube.h"
+// C++
+#include <algorithm>
+#include <cstring>
+
+TemporalCube::TemporalCube() :
+    data(0),
+    capacity(0),
+    frameLength(0),
+    tileSeries(0),
+    frames(0)
+{
+}
+
+TemporalCube::~TemporalCube()
+{
+    release();
+}
+
+bool TemporalCube::create(int capacity, int frameLength, int tileSeries)
+{
+    release();
+    if(capacity <= 0 || frameLength <= 0 || tileSeries <= 0)
+        return false;
+
+    const qint64 bytes = static_cast<qint64>(capacity) * frameLength * sizeof(float);
+    if(!file.open() || !file.resize(bytes))
+        return false;
+    data = file.map(0, bytes);
+    if(!data) {
+        release();
+        return false;
+    }
+
+    this->capacity = capacity;
+    this->frameLength = frameLength;
+    this->tileSeries = std::min(tileSeries, frameLength);
+    frames = 0;
+    return true;
+}
+
+void TemporalCube::release()
+{
+    if(data)
+        file.unmap(data);
+    data = 0;
+    if(file.isOpen()) {
+        file.close();
+        file.remove();
+    }
+    capacity = 0;
+    frameLength = 0;
+    tileSeries = 0;
+    frames = 0;
+}
+
+void TemporalCube::push(const cv::Mat &frame)
+{
+    CV_Assert(data && frame.type() == CV_32FC(frame.channels()) && frame.isContinuous() &&
+              static_cast<int>(frame.total()) * frame.channels() == frameLength);
+    if(frames >= capacity)
+        return;
+
+    // Every tile gets its part of the frame in its own row
+    const float *src = frame.ptr<float>();
+    for(int t = 0; t < numTiles(); ++t) {
+        const int width = tileWidth(t);
+        float *dst = reinterpret_cast<float*>(data) + static_cast<qint64>(t) * tileSeries * capacity +
+                     static_cast<qint64>(frames) * width;
+        std::memcpy(dst, src + t * tileSeries, width * sizeof(float));
+    }
+    ++frames;
+}
+
+void TemporalCube::frame(int position, cv::Mat &dst) const
+{
+    CV_Assert(data && position >= 0 && position < frames);
+    dst.create(1, frameLength, CV_32FC1);
+
+    float *out = dst.ptr<float>();
+    for(int t = 0; t < numTiles(); ++t) {
+        const int width = tileWidth(t);
+        const float *src = reinterpret_cast<const float*>(data) + static_cast<qint64>(t) * tileSeries * capacity +
+                           static_cast<qint64>(position) * width;
+        std::memcpy(out + t * tileSeries, src, width * sizeof(float));
+    }
+}
+
+cv::Mat TemporalCube::tile(int index)
+{
+    CV_Assert(data && index >= 0 && index < numTiles());
+    float *block = reinterpret_cast<float*>(data) + static_cast<qint64>(index) * tileSeries * capacity;
+    return cv::Mat(frames, tileWidth(index), CV_32FC1, block);
+}
+
+int TemporalCube::numTiles() const
+{
+    return tileSeries > 0 ? (frameLength + tileSeries - 1) / tileSeries : 0;
+}
+
+int TemporalCube::tileWidth(int index) const
+{
+    return std::min(tileSeries, frameLength - index * tileSeries);
+}
+
+int TemporalCube::size() const
+{
+    return frames;
+}
+
+bool TemporalCube::isOpen() const
+{
+    return data != 0;
+}
@@ -0,0 +1,94 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->TemporalCube.h                                     */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+
+#ifndef TEMPORALCUBE_H
+#define TEMPORALCUBE_H
+// Qt
+#include <QTemporaryFile>
+// OpenCV
+#include "opencv2/core/core.hpp"
+
+/*!
+ * \brief The TemporalCube class (Color Magnification) Every frame of a whole video as 32bit float series, kept in a
+ *  memory mapped temporary file instead of RAM. The series (pixels and channels of a frame) are grouped in tiles
+ *  of tileSeries each. A tile holds its series for all frames in one contiguous block, frame after frame, so a
+ *  tile can be filtered along time without touching the rest of the file.
+ */
+class TemporalCube
+{
+public:
+    TemporalCube();
+    ~TemporalCube();
+    /*!
+     * \brief create Maps a temporary file for a video.
+     * \param capacity Maximum number of frames.
+     * \param frameLength Number of floats of a frame (columns*rows*channels).
+     * \param tileSeries Number of series per tile.
+     * \return False if the file couldn't be created or mapped, e.g. if there's not enough disk or address space.
+     */
+    bool create(int capacity, int frameLength, int tileSeries);
+    /*!
+     * \brief release Unmaps and deletes the file.
+     */
+    void release();
+    /*!
+     * \brief push Appends a frame, ignored once capacity frames were added.
+     * \param frame Continuous 32bit float frame of frameLength values.
+     */
+    void push(const cv::Mat &frame);
+    /*!
+     * \brief frame Gathers a frame from all tiles.
+     * \param position Number of the frame, 0 for the first one.
+     * \param dst Frame as 1 row of frameLength floats.
+     */
+    void frame(int position, cv::Mat &dst) const;
+    /*!
+     * \brief tile All frames of a tile without copying, 1 row per frame and 1 column per series.
+     */
+    cv::Mat tile(int index);
+    int numTiles() const;
+    /*!
+     * \brief size Number of frames added.
+     */
+    int size() const;
+    bool isOpen() const;
+
+private:
+    // Not copyable, the mapping belongs to the file
+    TemporalCube(const TemporalCube &);
+    TemporalCube &operator=(const TemporalCube &);
+
+    // Number of series in a tile, only the last one may be narrower
+    int tileWidth(int index) const;
+
+    QTemporaryFile file;
+    uchar *data;
+    int capacity;
+    int frameLength;
+    int tileSeries;
+    int frames;
+};
+
+#endif // TEMPORALCUBE_H
@@ -23,6 +23,18 @@
 /************************************************************************************/
 
 #include "main/magnification/TemporalFilter.h"
+// OpenCV
+#include "opencv2/core/utility.hpp"
+// C++
+#include <algorithm>
+#include <limits>
+// SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 //using namespace cv;
 ////////////////////////
@@ -31,21 +43,144 @@
 void iirFilter(const cv::Mat &src, cv::Mat &dst, cv::Mat &lowpassHi, cv::Mat &lowpassLo,
                double cutoffLo, double cutoffHi)
 {
-    // Set minimum for cutoff, so low cutoff gets faded out
-    if(cutoffLo == 0)
-        cutoffLo = 0.01;
-
     /* The higher cutoff*, the faster the lowpass* image of the lowpass* pyramid gets faded out.
      * That means, a high cutoff weights new images (= \param src)
      * more than the old ones (= \param lowpass*), so long lasting movements are faded out fast.
      * The other way, a low cutoff evens out fast movements ocurring only in a few number of src images. */
+    iirBandpassAmplify(src, dst, lowpassHi, lowpassLo, cutoffLo, cutoffHi, 1.0);
+}
+
+////////////////////////
+///Fused iir kernels ///
+////////////////////////
+// One row of iirBandpassAmplify: lowpass = (1-cutoff)*lowpass + cutoff*src for both lowpass images,
+// dst = gain*(lowpassHi-lowpassLo). The vector variants use separate multiplies and adds (no FMA)
+// like the cv::Mat expressions this replaces.
+typedef void (*IirAmplifyRow)(const float *src, float *dst, float *lowpassHi, float *lowpassLo, int n,
+                              float cutoffLo, float cutoffHi, float gain);
+
+static void iirAmplifyRowScalar(const float *src, float *dst, float *lowpassHi, float *lowpassLo, int n,
+                                float cutoffLo, float cutoffHi, float gain)
+{
+    const float keepHi = 1.f - cutoffHi;
+    const float keepLo = 1.f - cutoffLo;
+    for(int i = 0; i < n; ++i) {
+        const float hi = keepHi*lowpassHi[i] + cutoffHi*src[i];
+        const float lo = keepLo*lowpassLo[i] + cutoffLo*src[i];
+        lowpassHi[i] = hi;
+        lowpassLo[i] = lo;
+        dst[i] = gain*(hi - lo);
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RVM_IIR_SSE2
+
+static void iirAmplifyRowSse2(const float *src, float *dst, float *lowpassHi, float *lowpassLo, int n,
+                              float cutoffLo, float cutoffHi, float gain)
+{
+    const __m128 vKeepHi = _mm_set1_ps(1.f - cutoffHi), vCutoffHi = _mm_set1_ps(cutoffHi);
+    const __m128 vKeepLo = _mm_set1_ps(1.f - cutoffLo), vCutoffLo = _mm_set1_ps(cutoffLo);
+    const __m128 vGain = _mm_set1_ps(gain);
+    int i = 0;
+    for(; i <= n - 4; i += 4) {
+        const __m128 s = _mm_loadu_ps(src + i);
+        const __m128 hi = _mm_add_ps(_mm_mul_ps(vKeepHi, _mm_loadu_ps(lowpassHi + i)), _mm_mul_ps(vCutoffHi, s));
+        const __m128 lo = _mm_add_ps(_mm_mul_ps(vKeepLo, _mm_loadu_ps(lowpassLo + i)), _mm_mul_ps(vCutoffLo, s));
+        _mm_storeu_ps(lowpassHi + i, hi);
+        _mm_storeu_ps(lowpassLo + i, lo);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(vGain, _mm_sub_ps(hi, lo)));
+    }
+    iirAmplifyRowScalar(src + i, dst + i, lowpassHi + i, lowpassLo + i, n - i, cutoffLo, cutoffHi, gain);
+}
+
+// 256 bit variant, compiled for AVX regardless of the compiler flags and only called if the CPU has it
+#if defined(__GNUC__) || defined(__clang__)
+#define RVM_TARGET_AVX __attribute__((target("avx")))
+#else
+#define RVM_TARGET_AVX
+#endif
+
+RVM_TARGET_AVX
+static void iirAmplifyRowAvx(const float *src, float *dst, float *lowpassHi, float *lowpassLo, int n,
+                             float cutoffLo, float cutoffHi, float gain)
+{
+    const __m256 vKeepHi = _mm256_set1_ps(1.f - cutoffHi), vCutoffHi = _mm256_set1_ps(cutoffHi);
+    const __m256 vKeepLo = _mm256_set1_ps(1.f - cutoffLo), vCutoffLo = _mm256_set1_ps(cutoffLo);
+    const __m256 vGain = _mm256_set1_ps(gain);
+    int i = 0;
+    for(; i <= n - 8; i += 8) {
+        const __m256 s = _mm256_loadu_ps(src + i);
+        const __m256 hi = _mm256_add_ps(_mm256_mul_ps(vKeepHi, _mm256_loadu_ps(lowpassHi + i)), _mm256_mul_ps(vCutoffHi, s));
+        const __m256 lo = _mm256_add_ps(_mm256_mul_ps(vKeepLo, _mm256_loadu_ps(lowpassLo + i)), _mm256_mul_ps(vCutoffLo, s));
+        _mm256_storeu_ps(lowpassHi + i, hi);
+        _mm256_storeu_ps(lowpassLo + i, lo);
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(vGain, _mm256_sub_ps(hi, lo)));
+    }
+    iirAmplifyRowSse2(src + i, dst + i, lowpassHi + i, lowpassLo + i, n - i, cutoffLo, cutoffHi, gain);
+}
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RVM_IIR_NEON
+
+static void iirAmplifyRowNeon(const float *src, float *dst, float *lowpassHi, float *lowpassLo, int n,
+                              float cutoffLo, float cutoffHi, float gain)
+{
+    const float32x4_t vKeepHi = vdupq_n_f32(1.f - cutoffHi), vCutoffHi = vdupq_n_f32(cutoffHi);
+    const float32x4_t vKeepLo = vdupq_n_f32(1.f - cutoffLo), vCutoffLo = vdupq_n_f32(cutoffLo);
+    const float32x4_t vGain = vdupq_n_f32(gain);
+    int i = 0;
+    for(; i <= n - 4; i += 4) {
+        const float32x4_t s = vld1q_f32(src + i);
+        const float32x4_t hi = vaddq_f32(vmulq_f32(vKeepHi, vld1q_f32(lowpassHi + i)), vmulq_f32(vCutoffHi, s));
+        const float32x4_t lo = vaddq_f32(vmulq_f32(vKeepLo, vld1q_f32(lowpassLo + i)), vmulq_f32(vCutoffLo, s));
+        vst1q_f32(lowpassHi + i, hi);
+        vst1q_f32(lowpassLo + i, lo);
+        vst1q_f32(dst + i, vmulq_f32(vGain, vsubq_f32(hi, lo)));
+    }
+    iirAmplifyRowScalar(src + i, dst + i, lowpassHi + i, lowpassLo + i, n - i, cutoffLo, cutoffHi, gain);
+}
+#endif
+
+static IirAmplifyRow selectIirAmplifyRow()
+{
+#if defined(RVM_IIR_SSE2)
+    if(cv::checkHardwareSupport(CV_CPU_AVX))
+        return iirAmplifyRowAvx;
+    return iirAmplifyRowSse2;
+#elif defined(RVM_IIR_NEON)
+    return iirAmplifyRowNeon;
+#else
+    return iirAmplifyRowScalar;
+#endif
+}
 
-    cv::Mat tmp1 = (1-cutoffHi)*lowpassHi + cutoffHi*src;
-    cv::Mat tmp2 = (1-cutoffLo)*lowpassLo + cutoffLo*src;
-    lowpassHi = tmp1;
-    lowpassLo = tmp2;
+void iirBandpassAmplify(const cv::Mat &src, cv::Mat &dst, cv::Mat &lowpassHi, cv::Mat &lowpassLo,
+                        double cutoffLo, double cutoffHi, double gain)
+{
+    // Set minimum for cutoff, so low cutoff gets faded out
+    if(cutoffLo == 0)
+        cutoffLo = 0.01;
+
+    CV_Assert(src.depth() == CV_32F);
+    CV_Assert(lowpassHi.type() == src.type() && lowpassHi.size() == src.size());
+    CV_Assert(lowpassLo.type() == src.type() && lowpassLo.size() == src.size());
+    dst.create(src.size(), src.type());
 
-    dst = lowpassHi - lowpassLo;
+    // Chosen on first use, the CPU doesn't change while running
+    static const IirAmplifyRow row = selectIirAmplifyRow();
+
+    int rows = src.rows;
+    int n = src.cols * src.channels();
+    if(src.isContinuous() && dst.isContinuous() && lowpassHi.isContinuous() && lowpassLo.isContinuous()) {
+        n *= rows;
+        rows = 1;
+    }
+
+    for(int y = 0; y < rows; ++y)
+        row(src.ptr<float>(y), dst.ptr<float>(y), lowpassHi.ptr<float>(y), lowpassLo.ptr<float>(y), n,
+            static_cast<float>(cutoffLo), static_cast<float>(cutoffHi), static_cast<float>(gain));
 }
 
 void iirWaveletFilter(const vector<cv::Mat> &src, vector<cv::Mat> &dst, vector<cv::Mat> &lowpassHi, vector<cv::Mat> &lowpassLo,
@@ -72,70 +207,416 @@ void iirWaveletFilter(const vector<cv::Mat> &src, vector<cv::Mat> &dst, vector<c
 }
 
 void idealFilter(const cv::Mat &src, cv::Mat &dst , double cutoffLo, double cutoffHi, double framerate)
+{
+    // Every thread that magnifies keeps its own plan
+    static thread_local IdealFilterPlan plan;
+    idealFilter(src, dst, cutoffLo, cutoffHi, framerate, plan);
+}
+
+void idealFilter(const cv::Mat &src, cv::Mat &dst, double cutoffLo, double cutoffHi, double framerate,
+                 IdealFilterPlan &plan)
+{
+    idealBandpass(src, dst, cutoffLo, cutoffHi, framerate, plan);
+    // Normalize to [0,1] like cv::NORM_MINMAX, remembering where zero went
+    double minVal, maxVal;
+    cv::minMaxLoc(dst.reshape(1), &minVal, &maxVal);
+    if(maxVal > minVal) {
+        dst.convertTo(dst, -1, 1.0/(maxVal-minVal), -minVal/(maxVal-minVal));
+        plan.zeroLevel = static_cast<float>(-minVal/(maxVal-minVal));
+    }
+    else {
+        dst.setTo(cv::Scalar::all(0));
+        plan.zeroLevel = 0;
+    }
+}
+
+// Ideal bandpass of the rows of a single channel matrix, src and dst may be the same
+static void filterSpectrum(const cv::Mat &src, cv::Mat &dst, const cv::Mat &filter, IdealFilterPlan &plan)
+{
+    // DFT
+    dft(src, plan.spectrum, cv::DFT_ROWS | cv::DFT_SCALE);
+    if(plan.collectPower)
+        plan.addPower(plan.spectrum);
+
+    // apply
+    mulSpectrums(plan.spectrum, filter, plan.spectrum, cv::DFT_ROWS);
+
+    // inverse
+    idft(plan.spectrum, dst, cv::DFT_ROWS | cv::DFT_SCALE);
+}
+
+void idealBandpass(const cv::Mat &src, cv::Mat &dst, double cutoffLo, double cutoffHi, double framerate,
+                   IdealFilterPlan &plan)
 {
     if(cutoffLo == 0.00)
         cutoffLo += 0.01;
 
-    int channelNrs = src.channels();
-    cv::Mat *channels = new cv::Mat[channelNrs];
-    split(src, channels);
+    // Mask is only rebuilt if the window or the settings changed
+    const cv::Mat &filter = plan.prepare(src.size(), cutoffLo, cutoffHi, framerate);
+    if(plan.collectPower)
+        plan.clearPower();
 
-    // Apply filter on each channel individually
-    for (int curChannel = 0; curChannel < channelNrs; ++curChannel) {
-        cv::Mat current = channels[curChannel];
-        cv::Mat tempImg;
+    // The rows are transformed independently, so they are not padded to an optimal DFT size:
+    // zero rows wouldn't change the result
+    if(src.channels() == 1) {
+        filterSpectrum(src, dst, filter, plan);
+        return;
+    }
 
-        int width = current.cols;
-        int height = cv::getOptimalDFTSize(current.rows);
+    // Interleaved channels aren't contiguous series, apply filter on each channel individually
+    split(src, plan.channels);
+    for (size_t curChannel = 0; curChannel < plan.channels.size(); ++curChannel)
+        filterSpectrum(plan.channels[curChannel], plan.channels[curChannel], filter, plan);
+    merge(plan.channels, dst);
+}
 
-        copyMakeBorder(current, tempImg,
-                       0, height - current.rows,
-                       0, width - current.cols,
-                       cv::BORDER_CONSTANT, cv::Scalar::all(0));
+void idealFilter(const TemporalRingBuffer &src, TemporalRingBuffer &dst, double cutoffLo, double cutoffHi, double framerate,
+                 IdealFilterPlan &plan)
+{
+    // The filter is circular (a product in the frequency domain), so the frames can be filtered in storage
+    // order: the result is rotated like src. 1 column = 1 frame for idealFilter.
+    // Seen as 1 channel, every pixel and channel of the frames is its own row after the transpose,
+    // so the series are filtered in one plane without splitting the channels
+    cv::transpose(src.stored().reshape(1), plan.series);
+    idealFilter(plan.series, plan.filtered, cutoffLo, cutoffHi, framerate, plan);
+    dst.copyLayout(src);
+    cv::Mat stored = dst.stored().reshape(1);
+    cv::transpose(plan.filtered, stored);
+}
+////////////////////////
+///Sliding DFT /////////
+////////////////////////
+SlidingDftBandpass::SlidingDftBandpass() :
+    windowLength(0),
+    frameLength(0),
+    channels(0),
+    cutoffLo(0),
+    cutoffHi(0),
+    framerate(0),
+    slidesSinceInit(0),
+    rangeMin(0),
+    rangeMax(0),
+    lastZeroLevel(0)
+{
+}
 
-        // DFT
-        dft(tempImg, tempImg, cv::DFT_ROWS | cv::DFT_SCALE);
+void SlidingDftBandpass::init(const TemporalRingBuffer &window, double cutoffLo, double cutoffHi, double framerate)
+{
+    CV_Assert(window.full());
+    windowLength = window.size();
+    frameLength = window.frame(0).cols;
+    channels = window.frame(0).channels();
+    this->cutoffLo = cutoffLo;
+    this->cutoffHi = cutoffHi;
+    this->framerate = framerate;
 
-        // construct Filter
-        cv::Mat filter = tempImg.clone();
-        createIdealBandpassFilter(filter, cutoffLo, cutoffHi, framerate);
+    // Same mask as idealFilter: createIdealBandpassFilter marks columns of the CCS packed spectrum,
+    // column 2k-1 is the real and column 2k the imaginary part of bin k
+    if(cutoffLo == 0.00)
+        cutoffLo += 0.01;
+    const float width = windowLength;
+    const double fl = 2 * cutoffLo * width / framerate;
+    const double fh = 2 * cutoffHi * width / framerate;
+    bins.clear();
+    weights.clear();
+    const double scale = 1.0 / (static_cast<double>(windowLength) * windowLength);
+    for(int k = 0; 2*k <= windowLength; ++k) {
+        const int re = (k == 0) ? 0 : 2*k-1;
+        const int im = 2*k;
+        // Bin 0 and, for even lengths, bin windowLength/2 are real and not mirrored
+        const bool realBin = (k == 0 || 2*k == windowLength);
+        const std::complex<double> response((re >= fl && re <= fh) ? 1.0 : 0.0,
+                                            (!realBin && im >= fl && im <= fh) ? 1.0 : 0.0);
+        if(response == 0.0)
+            continue;
+        bins.push_back(k);
+        weights.push_back(response * (realBin ? scale : 2.0*scale));
+    }
+
+    computeBins(window);
+}
+
+bool SlidingDftBandpass::isValidFor(const TemporalRingBuffer &window, double cutoffLo, double cutoffHi, double framerate) const
+{
+    return windowLength > 0 && window.full() && window.size() == windowLength &&
+           window.frame(0).cols == frameLength && window.frame(0).channels() == channels &&
+           cutoffLo == this->cutoffLo && cutoffHi == this->cutoffHi && framerate == this->framerate;
+}
+
+void SlidingDftBandpass::computeBins(const TemporalRingBuffer &window)
+{
+    const int numBins = static_cast<int>(bins.size());
+    const int series = frameLength * channels;
+    spectrum.assign(series * numBins, std::complex<double>(0.0, 0.0));
+    slidesSinceInit = 0;
+
+    // S_k = sum_n x_n * e^(-2*pi*i*k*n/windowLength), oldest frame is n = 0. Frame by frame, each is contiguous
+    std::vector< std::complex<double> > twiddle(numBins);
+    for(int n = 0; n < windowLength; ++n) {
+        for(int b = 0; b < numBins; ++b)
+            twiddle[b] = std::polar(1.0, -2.0 * M_PI * bins[b] * n / windowLength);
+        const float *samples = window.frame(n).ptr<float>();
+        for(int s = 0; s < series; ++s) {
+            std::complex<double> *bin = &spectrum[s*numBins];
+            for(int b = 0; b < numBins; ++b)
+                bin[b] += static_cast<double>(samples[s]) * twiddle[b];
+        }
+    }
+
+    // Range of the whole filtered window, like idealFilter. Costs about as much as the bins themselves
+    rangeMin = std::numeric_limits<float>::max();
+    rangeMax = -std::numeric_limits<float>::max();
+    for(int position = 0; position < windowLength; ++position) {
+        float minVal, maxVal;
+        bandpassFrame(position, rangeFrame, minVal, maxVal);
+        rangeMin = std::min(rangeMin, minVal);
+        rangeMax = std::max(rangeMax, maxVal);
+    }
+}
+
+void SlidingDftBandpass::slide(const TemporalRingBuffer &window, const cv::Mat &leaving)
+{
+    CV_Assert(window.size() == windowLength && leaving.cols == frameLength && leaving.channels() == channels);
+    // Recompute now and then, so rounding errors of the updates don't add up
+    if(++slidesSinceInit >= windowLength) {
+        computeBins(window);
+        return;
+    }
+
+    // S_k' = (S_k - x_oldest + x_newest) * e^(2*pi*i*k/windowLength)
+    const int numBins = static_cast<int>(bins.size());
+    const int series = frameLength * channels;
+    std::vector< std::complex<double> > rotation(numBins);
+    for(int b = 0; b < numBins; ++b)
+        rotation[b] = std::polar(1.0, 2.0 * M_PI * bins[b] / windowLength);
+    const float *newest = window.frame(windowLength-1).ptr<float>();
+    const float *old = leaving.ptr<float>();
+    for(int s = 0; s < series; ++s) {
+        const double delta = static_cast<double>(newest[s]) - old[s];
+        std::complex<double> *bin = &spectrum[s*numBins];
+        for(int b = 0; b < numBins; ++b)
+            bin[b] = (bin[b] + delta) * rotation[b];
+    }
+}
+
+void SlidingDftBandpass::filteredFrame(int position, cv::Mat &dst)
+{
+    float minVal, maxVal;
+    bandpassFrame(position, dst, minVal, maxVal);
+
+    // Normalize to [0,1] with the range of the window at the last recomputation and the frames returned since
+    rangeMin = std::min(rangeMin, minVal);
+    rangeMax = std::max(rangeMax, maxVal);
+    if(rangeMax > rangeMin) {
+        dst.convertTo(dst, dst.type(), 1.0/(rangeMax-rangeMin), -rangeMin/(rangeMax-rangeMin));
+        lastZeroLevel = -rangeMin/(rangeMax-rangeMin);
+    }
+    else {
+        dst.setTo(cv::Scalar::all(0));
+        lastZeroLevel = 0;
+    }
+}
+
+void SlidingDftBandpass::bandpassFrame(int position, cv::Mat &dst) const
+{
+    float minVal, maxVal;
+    bandpassFrame(position, dst, minVal, maxVal);
+}
+
+void SlidingDftBandpass::bandpassFrame(int position, cv::Mat &dst, float &minVal, float &maxVal) const
+{
+    dst.create(1, frameLength, CV_MAKETYPE(CV_32F, channels));
+    const int numBins = static_cast<int>(bins.size());
+    const int series = frameLength * channels;
+    // Inverse DFT at a single sample: y_n = sum_k Re(weight_k * S_k * e^(2*pi*i*k*n/windowLength))
+    std::vector< std::complex<double> > phase(numBins);
+    for(int b = 0; b < numBins; ++b)
+        phase[b] = weights[b] * std::polar(1.0, 2.0 * M_PI * bins[b] * position / windowLength);
+
+    minVal = std::numeric_limits<float>::max();
+    maxVal = -std::numeric_limits<float>::max();
+    float *out = dst.ptr<float>();
+    for(int s = 0; s < series; ++s) {
+        const std::complex<double> *bin = &spectrum[s*numBins];
+        double sum = 0;
+        for(int b = 0; b < numBins; ++b)
+            sum += (phase[b] * bin[b]).real();
+        out[s] = static_cast<float>(sum);
+        minVal = std::min(minVal, out[s]);
+        maxVal = std::max(maxVal, out[s]);
+    }
+}
 
-        // apply
-        mulSpectrums(tempImg, filter, tempImg, cv::DFT_ROWS);
+float SlidingDftBandpass::zeroLevel() const
+{
+    return lastZeroLevel;
+}
+
+const std::vector<int> &SlidingDftBandpass::passbandBins() const
+{
+    return bins;
+}
 
-        // inverse
-        idft(tempImg, tempImg, cv::DFT_ROWS | cv::DFT_SCALE);
+void SlidingDftBandpass::binPower(std::vector<double> &power) const
+{
+    const int numBins = static_cast<int>(bins.size());
+    const int series = frameLength * channels;
+    power.assign(numBins, 0.0);
+    if(spectrum.size() != static_cast<size_t>(series * numBins))
+        return;
 
-        tempImg(cv::Rect(0, 0, current.cols, current.rows)).copyTo(channels[curChannel]);
+    // The sliding update rotates the phase of the bins, their magnitude is the one of the window
+    for(int s = 0; s < series; ++s) {
+        const std::complex<double> *bin = &spectrum[s*numBins];
+        for(int b = 0; b < numBins; ++b)
+            power[b] += std::norm(bin[b]);
     }
-    merge(channels, channelNrs, dst);
+}
 
-    normalize(dst, dst, 0, 1, cv::NORM_MINMAX);
-    delete [] channels;
+void SlidingDftBandpass::reset()
+{
+    windowLength = 0;
+    spectrum.clear();
+    rangeMin = 0;
+    rangeMax = 0;
+    lastZeroLevel = 0;
 }
 
 void createIdealBandpassFilter(cv::Mat &filter, double cutoffLo, double cutoffHi, double framerate)
 {
     float width = filter.cols;
-    float height = filter.rows;
 
     // Calculate frequencies according to framerate and size
     double fl = 2 * cutoffLo * width / framerate;
     double fh = 2 * cutoffHi * width / framerate;
 
-    double response;
+    // Create the filtermask, the response only depends on the column
+    CV_Assert(filter.type() == CV_32FC1);
+    if(filter.rows == 0)
+        return;
+    float *response = filter.ptr<float>(0);
+    for (int x = 0; x < filter.cols; ++x)
+        response[x] = (x >= fl && x <= fh) ? 1.0f : 0.0f;
+    for(int y = 1; y < filter.rows; ++y)
+        filter.row(0).copyTo(filter.row(y));
+}
+
+////////////////////////
+///Filter plan /////////
+////////////////////////
+IdealFilterPlan::IdealFilterPlan() :
+    collectPower(false),
+    zeroLevel(0),
+    cutoffLo(0),
+    cutoffHi(0),
+    framerate(0),
+    firstColumn(0),
+    lastColumn(-1)
+{
+}
 
-    // Create the filtermask, looks like the quarter of a circle
-    for(int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if(x >= fl && x <= fh)
-                response = 1.0f;
-            else
-                response = 0.0f;
+const cv::Mat &IdealFilterPlan::prepare(const cv::Size &size, double cutoffLo, double cutoffHi, double framerate)
+{
+    if(filter.empty() || size != this->size || cutoffLo != this->cutoffLo ||
+       cutoffHi != this->cutoffHi || framerate != this->framerate) {
+        this->size = size;
+        this->cutoffLo = cutoffLo;
+        this->cutoffHi = cutoffHi;
+        this->framerate = framerate;
+        filter.create(size, CV_32FC1);
+        createIdealBandpassFilter(filter, cutoffLo, cutoffHi, framerate);
 
-            filter.at<float>(y,x) = response;
+        // The passband is one range of columns, the same in every row
+        firstColumn = 0;
+        lastColumn = -1;
+        if(filter.rows > 0) {
+            const float *response = filter.ptr<float>(0);
+            for(int x = 0; x < filter.cols; ++x) {
+                if(response[x] == 0)
+                    continue;
+                if(lastColumn < firstColumn)
+                    firstColumn = x;
+                lastColumn = x;
+            }
+        }
+        // CCS packing: column 0 is bin 0, columns 2k-1 and 2k are bin k, the last column of an even length is bin cols/2
+        powerBins.clear();
+        for(int x = firstColumn; x <= lastColumn; ++x) {
+            const int bin = (x+1)/2;
+            if(powerBins.empty() || powerBins.back() != bin)
+                powerBins.push_back(bin);
         }
     }
+    return filter;
+}
+
+void IdealFilterPlan::clearPower()
+{
+    binPower.assign(powerBins.size(), 0.0);
+}
+
+void IdealFilterPlan::addPower(const cv::Mat &spectrum)
+{
+    if(lastColumn < firstColumn || powerBins.empty())
+        return;
+    if(binPower.size() != powerBins.size())
+        clearPower();
+
+    // Only the passband columns, summed over all rows
+    const cv::Mat band = spectrum.colRange(firstColumn, lastColumn+1);
+    cv::multiply(band, band, squared);
+    cv::reduce(squared, columnPower, 0, cv::REDUCE_SUM, CV_64F);
+
+    const double *column = columnPower.ptr<double>(0);
+    for(int x = firstColumn; x <= lastColumn; ++x)
+        binPower[(x+1)/2 - powerBins.front()] += column[x - firstColumn];
+}
+
+void IdealFilterPlan::reset()
+{
+    filter.release();
+    channels.clear();
+    series.release();
+    filtered.release();
+    spectrum.release();
+    powerBins.clear();
+    binPower.clear();
+    zeroLevel = 0;
+    firstColumn = 0;
+    lastColumn = -1;
+}
+
+bool dominantRate(const std::vector<int> &bins, const std::vector<double> &power, int windowLength, double framerate,
+                  double &ratePerMinute, double &confidence)
+{
+    ratePerMinute = 0;
+    confidence = 0;
+    if(bins.empty() || bins.size() != power.size() || windowLength <= 0 || framerate <= 0)
+        return false;
+
+    size_t peak = 0;
+    double total = 0;
+    for(size_t i = 0; i < power.size(); ++i) {
+        total += power[i];
+        if(power[i] > power[peak])
+            peak = i;
+    }
+    if(total <= 0)
+        return false;
+
+    // Parabola through the peak and its direct neighbours, shifts the peak by at most half a bin
+    double offset = 0;
+    if(peak > 0 && peak+1 < power.size() &&
+       bins[peak-1] == bins[peak]-1 && bins[peak+1] == bins[peak]+1) {
+        const double left = power[peak-1], center = power[peak], right = power[peak+1];
+        const double curvature = left - 2*center + right;
+        if(curvature < 0)
+            offset = std::max(-0.5, std::min(0.5, 0.5*(left - right)/curvature));
+    }
+
+    ratePerMinute = 60.0 * (bins[peak] + offset) * framerate / windowLength;
+    confidence = power[peak] / total;
+    return true;
 }
 
 ////////////////////////
@@ -171,6 +652,11 @@ void tempMat2img(const cv::Mat &src, int position, const cv::Size &frameSize, cv
     cv::Mat line = src.col(position).clone();
     frame = line.reshape(line.channels(), frameSize.height).clone();
 }
+void tempMat2img(const TemporalRingBuffer &src, int position, const cv::Size &frameSize, cv::Mat &frame)
+{
+    const cv::Mat line = src.frame(position);
+    line.reshape(line.channels(), frameSize.height).copyTo(frame);
+}
 
 ////////////////////////
 ///Butterworth /////////
@@ -452,3 +938,87 @@ void RieszTemporalFilter::pass(CompExpMat &result,
     passEach(cos(result), cos(phase), cos(prior));
     passEach(sin(result), sin(phase), sin(prior));
 }
+
+////////////////////////////////////////
+// Causal Butterworth Bandpass Filter //
+////////////////////////////////////////
+ButterworthBandpass::ButterworthBandpass() :
+    cutoffLo(-1),
+    cutoffHi(-1),
+    framerate(-1),
+    aLo(0),
+    aHi(0)
+{
+    bLo[0] = bLo[1] = 0;
+    bHi[0] = bHi[1] = 0;
+}
+
+void ButterworthBandpass::updateCoefficients(double cutoffLo, double cutoffHi, double framerate)
+{
+    if(cutoffLo == this->cutoffLo && cutoffHi == this->cutoffHi && framerate == this->framerate)
+        return;
+    this->cutoffLo = cutoffLo;
+    this->cutoffHi = cutoffHi;
+    this->framerate = framerate;
+
+    // Same design as RieszTemporalFilter::computeCoefficients, kept below the Nyquist frequency
+    std::vector<double> a, b;
+    const double loWn = std::min(std::max(cutoffLo, 0.01) / (framerate/2.0), 0.99);
+    butterworth(1, loWn, a, b);
+    bLo[0] = static_cast<float>(b[0] / a[0]);
+    bLo[1] = static_cast<float>(b[1] / a[0]);
+    aLo = static_cast<float>(a[1] / a[0]);
+    const double hiWn = std::min(std::max(cutoffHi, 0.01) / (framerate/2.0), 0.99);
+    butterworth(1, hiWn, a, b);
+    bHi[0] = static_cast<float>(b[0] / a[0]);
+    bHi[1] = static_cast<float>(b[1] / a[0]);
+    aHi = static_cast<float>(a[1] / a[0]);
+}
+
+void ButterworthBandpass::filter(const cv::Mat &src, cv::Mat &dst, double cutoffLo, double cutoffHi, double framerate)
+{
+    CV_Assert(src.depth() == CV_32F && framerate > 0);
+    dst.create(src.size(), src.type());
+
+    // A constant signal is its own lowpass, so starting on the first frame doesn't ring
+    if(prior.empty() || prior.size() != src.size() || prior.type() != src.type()) {
+        src.copyTo(prior);
+        src.copyTo(lowpassLo);
+        src.copyTo(lowpassHi);
+        dst.setTo(cv::Scalar::all(0));
+        return;
+    }
+    updateCoefficients(cutoffLo, cutoffHi, framerate);
+
+    int rows = src.rows;
+    int n = src.cols * src.channels();
+    if(src.isContinuous() && dst.isContinuous() && prior.isContinuous() &&
+       lowpassLo.isContinuous() && lowpassHi.isContinuous()) {
+        n *= rows;
+        rows = 1;
+    }
+
+    for(int y = 0; y < rows; ++y) {
+        const float *in = src.ptr<float>(y);
+        float *out = dst.ptr<float>(y);
+        float *last = prior.ptr<float>(y);
+        float *lo = lowpassLo.ptr<float>(y);
+        float *hi = lowpassHi.ptr<float>(y);
+        for(int i = 0; i < n; ++i) {
+            const float x = in[i];
+            const float l = bLo[0]*x + bLo[1]*last[i] - aLo*lo[i];
+            const float h = bHi[0]*x + bHi[1]*last[i] - aHi*hi[i];
+            lo[i] = l;
+            hi[i] = h;
+            last[i] = x;
+            out[i] = h - l;
+        }
+    }
+}
+
+void ButterworthBandpass::reset()
+{
+    prior.release();
+    lowpassLo.release();
+    lowpassHi.release();
+}
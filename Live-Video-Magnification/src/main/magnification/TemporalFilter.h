@@ -27,10 +27,14 @@
 
 // Project
 #include "main/helper/ComplexMat.h"
+#include "main/magnification/TemporalRingBuffer.h"
 // OpenCV
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 #include "opencv2/highgui/highgui.hpp"
+// C++
+#include <complex>
+#include <vector>
 
 #define M_PI 3.14159265358979323846264338327950288
 
@@ -57,6 +61,14 @@ void img2tempMat(const cv::Mat &frame, cv::Mat &dst, int maxImages);
  * \param frame Output frame with size frameSize.
  */
 void tempMat2img(const cv::Mat &src, int position, const cv::Size &frameSize, cv::Mat &frame);
+/*!
+ * \brief tempMat2img (Color Magnification) Takes 1 frame of a ring buffer and reshapes it back into a frame.
+ * \param src Ring buffer of frames.
+ * \param position The frame in src, 0 for the oldest.
+ * \param frameSize The destination size the reshaped frame shall have.
+ * \param frame Output frame with size frameSize.
+ */
+void tempMat2img(const TemporalRingBuffer &src, int position, const cv::Size &frameSize, cv::Mat &frame);
 /*!
  * \brief createIdealBandpassFilter (Color Magnification) Creates a filter mask for an ideal filter.
  * \param filter Filter mask.
@@ -79,6 +91,20 @@ void createIdealBandpassFilter(cv::Mat &filter, double cutoffLo, double cutoffHi
  * \param cutoffHi Higher cutoff frequency.
  */
 void iirFilter(const cv::Mat &src, cv::Mat &dst, cv::Mat &lowpassHi, cv::Mat &lowpassLo, double cutoffLo, double cutoffHi);
+/*!
+ * \brief iirBandpassAmplify (Euler Magnification) iirFilter and amplification of its result fused in one
+ *  pass over memory: per element both lowpass images are updated in place and the amplified difference
+ *  is written to dst. Uses AVX, SSE2 or NEON, chosen once at runtime.
+ * \param src Newest input image of a level of a Laplace Pyramid, 32bit float.
+ * \param dst Amplified iir filtered level. Reused if it already has the size and type of src.
+ * \param lowpassHi Holding the informations about the previous (high) lowpass filtered images of a level.
+ * \param lowpassLo Holding the informations about the previous (low) lowpass filtered images of a level.
+ * \param cutoffLo Lower cutoff frequency.
+ * \param cutoffHi Higher cutoff frequency.
+ * \param gain Factor the filtered level is multiplied with.
+ */
+void iirBandpassAmplify(const cv::Mat &src, cv::Mat &dst, cv::Mat &lowpassHi, cv::Mat &lowpassLo,
+                        double cutoffLo, double cutoffHi, double gain);
 /*!
  * \brief iirWaveletFilter (Wavelet Magnification) Applies an iirFilter (in space domain) on 1 level of a DWT.
  * \param src
@@ -90,14 +116,200 @@ void iirFilter(const cv::Mat &src, cv::Mat &dst, cv::Mat &lowpassHi, cv::Mat &lo
  */
 void iirWaveletFilter(const vector<cv::Mat> &src, vector<cv::Mat> &dst, vector<cv::Mat> &lowpassHi, vector<cv::Mat> &lowpassLo, double cutoffLo, double cutoffHi);
 /*!
- * \brief idealFilter (Color Magnification)
- * \param src
- * \param dst
- * \param cutoffLo
- * \param cutoffHi
- * \param framerate
+ * \brief The IdealFilterPlan class (Color Magnification) Bandpass mask and scratch memory of idealFilter.
+ *  The mask only depends on the size of the temporal matrix, the framerate and the cutoffs; it is rebuilt
+ *  when one of them changes, e.g. when the options or the measured framerate change.
+ *  With collectPower set, idealFilter also sums the power of every passband bin over all rows and channels
+ *  of the spectrum it computes anyway, see dominantRate.
+ */
+class IdealFilterPlan
+{
+public:
+    IdealFilterPlan();
+    /*!
+     * \brief prepare Mask for a temporal matrix, rebuilt only if size or settings differ from the last call.
+     * \param size Size of the temporal matrix.
+     * \param cutoffLo Lower cutoff frequency.
+     * \param cutoffHi Upper cutoff frequency.
+     * \param framerate Framerate of processed video.
+     * \return Mask like createIdealBandpassFilter.
+     */
+    const cv::Mat &prepare(const cv::Size &size, double cutoffLo, double cutoffHi, double framerate);
+    /*!
+     * \brief reset Drops the mask and the scratch memory.
+     */
+    void reset();
+
+    /*!
+     * \brief addPower Adds the power of the passband columns of a CCS packed spectrum to binPower.
+     * \param spectrum Spectrum of idealFilter, one row per series.
+     */
+    void addPower(const cv::Mat &spectrum);
+    /*!
+     * \brief clearPower Starts a new sum of the passband power.
+     */
+    void clearPower();
+
+    // Scratch memory of idealFilter, reused while the size stays the same.
+    // channels only for matrices with interleaved channels, series and filtered for ring buffers
+    std::vector<cv::Mat> channels;
+    cv::Mat series;
+    cv::Mat filtered;
+    cv::Mat spectrum;
+    // Sum the passband power during idealFilter
+    bool collectPower;
+    // Passband bin numbers and their power summed over every series, valid after idealFilter with collectPower
+    std::vector<int> powerBins;
+    std::vector<double> binPower;
+    // Value a zero bandpass output was normalized to by the last idealFilter
+    float zeroLevel;
+
+private:
+    cv::Size size;
+    double cutoffLo;
+    double cutoffHi;
+    double framerate;
+    cv::Mat filter;
+    // Passband columns of the mask, lastColumn < firstColumn if it is empty
+    int firstColumn;
+    int lastColumn;
+    cv::Mat squared;
+    cv::Mat columnPower;
+};
+
+/*!
+ * \brief idealFilter (Color Magnification) Ideal bandpass along the rows of a temporal matrix, normalized to [0,1].
+ *  Uses a plan kept per thread.
+ * \param src Temporal matrix, 1 column = 1 frame.
+ * \param dst Filtered matrix.
+ * \param cutoffLo Lower cutoff frequency.
+ * \param cutoffHi Upper cutoff frequency.
+ * \param framerate Framerate of processed video.
  */
 void idealFilter(const cv::Mat &src, cv::Mat &dst, double cutoffLo, double cutoffHi, double framerate);
+/*!
+ * \brief idealFilter (Color Magnification) idealFilter with a plan of the caller.
+ * \param plan Mask and scratch memory, kept between calls.
+ */
+void idealFilter(const cv::Mat &src, cv::Mat &dst, double cutoffLo, double cutoffHi, double framerate,
+                 IdealFilterPlan &plan);
+/*!
+ * \brief idealBandpass (Color Magnification) idealFilter without the normalization, for series that are filtered
+ *  in parts and normalized together.
+ */
+void idealBandpass(const cv::Mat &src, cv::Mat &dst, double cutoffLo, double cutoffHi, double framerate,
+                   IdealFilterPlan &plan);
+/*!
+ * \brief idealFilter (Color Magnification) idealFilter on the frames of a ring buffer. Every channel of
+ *  every pixel is filtered as a row of one single channel matrix, no channel is split off or merged.
+ * \param src Frames to filter.
+ * \param dst Filtered frames, at the same positions as in src.
+ * \param cutoffLo Lower cutoff frequency.
+ * \param cutoffHi Upper cutoff frequency.
+ * \param framerate Framerate of processed video.
+ * \param plan Mask and scratch memory, kept between calls.
+ */
+void idealFilter(const TemporalRingBuffer &src, TemporalRingBuffer &dst, double cutoffLo, double cutoffHi, double framerate,
+                 IdealFilterPlan &plan);
+
+/*!
+ * \brief dominantRate (Color Magnification) Strongest frequency of a passband spectrum, as events per minute.
+ * \param bins DFT bin numbers, ascending.
+ * \param power Power of every bin, summed over all pixels and channels.
+ * \param windowLength Number of frames the DFT was taken over.
+ * \param framerate Framerate of processed video.
+ * \param ratePerMinute 60 times the frequency of the strongest bin, refined with a parabola through its neighbours.
+ * \param confidence Share of the strongest bin in the power of all bins, 1 if it is the only one.
+ * \return False if there is no power to look at, both outputs are 0 then.
+ */
+bool dominantRate(const std::vector<int> &bins, const std::vector<double> &power, int windowLength, double framerate,
+                  double &ratePerMinute, double &confidence);
+
+/*!
+ * \brief The SlidingDftBandpass class (Color Magnification) Streaming version of idealFilter for a window
+ *  that slides by one frame at a time. Only the DFT bins in the passband are kept per series (one pixel and
+ *  channel of the frames) and updated with a sliding DFT, so a slide costs O(series * bins)
+ *  instead of a DFT of the whole window. The passband response is the one of createIdealBandpassFilter.
+ *  To stop rounding errors from adding up, the bins are recomputed from the window every windowLength slides.
+ *  idealFilter normalizes with the range of the whole filtered window. Here that range is taken whenever the
+ *  bins are recomputed and widened by every frame filteredFrame returns until the next recomputation. So the
+ *  gain equals the one of idealFilter right after init and every recomputation, and may only drift from it
+ *  for less than windowLength slides.
+ */
+class SlidingDftBandpass
+{
+public:
+    SlidingDftBandpass();
+    /*!
+     * \brief init Computes the passband bins of a full window.
+     * \param window Full ring buffer of frames.
+     * \param cutoffLo Lower cutoff frequency.
+     * \param cutoffHi Upper cutoff frequency.
+     * \param framerate Framerate of processed video.
+     */
+    void init(const TemporalRingBuffer &window, double cutoffLo, double cutoffHi, double framerate);
+    /*!
+     * \brief isValidFor True if the window is full and init was called for one of its shape and these settings.
+     */
+    bool isValidFor(const TemporalRingBuffer &window, double cutoffLo, double cutoffHi, double framerate) const;
+    /*!
+     * \brief slide Updates the bins after the window moved by one frame.
+     * \param window Window that already holds the newest frame.
+     * \param leaving Frame that was dropped from the window, see TemporalRingBuffer::push.
+     */
+    void slide(const TemporalRingBuffer &window, const cv::Mat &leaving);
+    /*!
+     * \brief filteredFrame Bandpass filtered and normalized frame of the window, like a frame of idealFilter.
+     * \param position Frame of the window, 0 for the oldest.
+     * \param dst Filtered frame as 1 row, same type as the frames of the window.
+     */
+    void filteredFrame(int position, cv::Mat &dst);
+    /*!
+     * \brief bandpassFrame filteredFrame without the normalization, like a frame of idealBandpass.
+     */
+    void bandpassFrame(int position, cv::Mat &dst) const;
+    /*!
+     * \brief zeroLevel Value a zero bandpass output was normalized to by the last filteredFrame.
+     */
+    float zeroLevel() const;
+    /*!
+     * \brief passbandBins DFT bin numbers that are kept, valid after init.
+     */
+    const std::vector<int> &passbandBins() const;
+    /*!
+     * \brief binPower Power of every passband bin summed over all series, see dominantRate.
+     * \param power One value per element of passbandBins.
+     */
+    void binPower(std::vector<double> &power) const;
+    /*!
+     * \brief reset Invalidates the state, the next window has to be passed to init.
+     */
+    void reset();
+
+private:
+    // Recomputes bins from the samples of the window and takes the range of the whole filtered window
+    void computeBins(const TemporalRingBuffer &window);
+    // bandpassFrame, also returns the range of the frame
+    void bandpassFrame(int position, cv::Mat &dst, float &minVal, float &maxVal) const;
+
+    int windowLength;
+    int frameLength;
+    int channels;
+    double cutoffLo;
+    double cutoffHi;
+    double framerate;
+    // Passband bin numbers and their weights: mask * inverse DFT factor * both DFT_SCALEs
+    std::vector<int> bins;
+    std::vector< std::complex<double> > weights;
+    // frameLength*channels series, bins.size() values each
+    std::vector< std::complex<double> > spectrum;
+    int slidesSinceInit;
+    // Minimum and maximum of the filtered window at the last computeBins and of the frames returned since
+    float rangeMin;
+    float rangeMax;
+    cv::Mat rangeFrame;
+    float lastZeroLevel;
+};
 
 ///
 // From https://github.com/tbl3rd/Pyramids
@@ -133,4 +345,46 @@ public:
               const CompExpMat &prior);
 };
 
+/*!
+ * \brief The ButterworthBandpass class (Color Magnification) Causal bandpass per pixel, the difference of two
+ *  first order Butterworth lowpasses designed like RieszTemporalFilter. Needs no window of frames: the state is
+ *  the previous frame and both lowpassed frames, so every frame is filtered as soon as it arrives.
+ *  Unlike idealFilter the result is not normalized.
+ */
+class ButterworthBandpass
+{
+public:
+    ButterworthBandpass();
+    /*!
+     * \brief filter Filters the next frame. The first frame, or one of another size or type, restarts the filter
+     *  and gives a zero image.
+     * \param src Frame, CV_32F with any number of channels.
+     * \param dst Bandpass filtered frame, reused if it has the size and type of src.
+     * \param cutoffLo Lower cutoff frequency.
+     * \param cutoffHi Upper cutoff frequency.
+     * \param framerate Framerate of processed video.
+     */
+    void filter(const cv::Mat &src, cv::Mat &dst, double cutoffLo, double cutoffHi, double framerate);
+    /*!
+     * \brief reset Drops the state, the next frame restarts the filter.
+     */
+    void reset();
+
+private:
+    // Recomputes the coefficients if a cutoff or the framerate changed
+    void updateCoefficients(double cutoffLo, double cutoffHi, double framerate);
+
+    double cutoffLo;
+    double cutoffHi;
+    double framerate;
+    // lowpass = b0*src + b1*prior - a1*lowpass, normalized so a0 is 1
+    float bLo[2];
+    float aLo;
+    float bHi[2];
+    float aHi;
+    cv::Mat prior;
+    cv::Mat lowpassLo;
+    cv::Mat lowpassHi;
+};
+
 #endif // TEMPORALFILTER_H
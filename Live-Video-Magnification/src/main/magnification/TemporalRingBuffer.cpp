@@ -0,0 +1,118 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->TemporalRingBuffer.cpp                             */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#include "main/magnification/TemporalRingBuffer.h"
+// C++
+#include <algorithm>
+
+TemporalRingBuffer::TemporalRingBuffer() :
+    oldest(0),
+    count(0)
+{
+}
+
+void TemporalRingBuffer::push(const cv::Mat &img, int capacity, cv::Mat *dropped)
+{
+    CV_Assert(capacity > 0);
+    const cv::Mat row = (img.isContinuous() ? img : img.clone()).reshape(img.channels(), 1);
+    const int type = CV_MAKETYPE(CV_32F, img.channels());
+
+    if(data.cols != row.cols || data.type() != type) {
+        // Different frames, start over
+        data.create(capacity, row.cols, type);
+        oldest = 0;
+        count = 0;
+    }
+    else if(data.rows != capacity) {
+        // Keep the newest frames in order
+        cv::Mat resized(capacity, row.cols, type);
+        const int kept = std::min(count, capacity);
+        for(int i = 0; i < kept; ++i)
+            frame(count - kept + i).copyTo(resized.row(i));
+        data = resized;
+        oldest = 0;
+        count = kept;
+    }
+
+    if(dropped)
+        dropped->release();
+
+    int slot;
+    if(count < data.rows) {
+        slot = count++;
+    }
+    else {
+        slot = oldest;
+        if(dropped)
+            data.row(slot).copyTo(*dropped);
+        oldest = (oldest + 1) % data.rows;
+    }
+    // Writes straight into the row, its size and type already match
+    cv::Mat target = data.row(slot);
+    row.convertTo(target, type);
+}
+
+cv::Mat TemporalRingBuffer::frame(int position) const
+{
+    CV_Assert(position >= 0 && position < count);
+    return data.row((oldest + position) % data.rows);
+}
+
+cv::Mat TemporalRingBuffer::stored() const
+{
+    return data.rowRange(0, count);
+}
+
+void TemporalRingBuffer::copyLayout(const TemporalRingBuffer &other)
+{
+    data.create(other.data.size(), other.data.type());
+    oldest = other.oldest;
+    count = other.count;
+}
+
+int TemporalRingBuffer::size() const
+{
+    return count;
+}
+
+int TemporalRingBuffer::capacity() const
+{
+    return data.rows;
+}
+
+bool TemporalRingBuffer::full() const
+{
+    return count > 0 && count == data.rows;
+}
+
+int TemporalRingBuffer::head() const
+{
+    return oldest;
+}
+
+void TemporalRingBuffer::clear()
+{
+    oldest = 0;
+    count = 0;
+}
@@ -0,0 +1,78 @@
+/************************************************************************************/
+/* An OpenCV/Qt based realtime application to magnify motion and color              */
+/* Copyright (C) 2015  Jens Schindel <kontakt@jens-schindel.de>                     */
+/*                                                                                  */
+/* Based on the work of                                                             */
+/*      Joseph Pan      <https://github.com/wzpan/QtEVM>                            */
+/*      Nick D'Ademo    <https://github.com/nickdademo/qt-opencv-multithreaded>     */
+/*                                                                                  */
+/* Realtime-Video-Magnification->TemporalRingBuffer.h                               */
+/*                                                                                  */
+/* This program is free software: you can redistribute it and/or modify             */
+/* it under the terms of the GNU General Public License as published by             */
+/* the Free Software Foundation, either version 3 of the License, or                */
+/* (at your option) any later version.                                              */
+/*                                                                                  */
+/* This program is distributed in the hope that it will be useful,                  */
+/* but WITHOUT ANY WARRANTY; without even the implied warranty of                   */
+/* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    */
+/* GNU General Public License for more details.                                     */
+/*                                                                                  */
+/* You should have received a copy of the GNU General Public License                */
+/* along with this program.  If not, see <http://www.gnu.org/licenses/>.            */
+/************************************************************************************/
+
+#ifndef TEMPORALRINGBUFFER_H
+#define TEMPORALRINGBUFFER_H
+// OpenCV
+#include "opencv2/core/core.hpp"
+
+/*!
+ * \brief The TemporalRingBuffer class (Color Magnification) Fixed capacity store of the last frames of a video,
+ *  replacing a matrix that is concatenated and trimmed every frame. Every frame is reshaped into one
+ *  contiguous 32bit float row; a new frame overwrites the oldest row and advances the head, nothing else
+ *  is copied. Positions passed to frame() count from the oldest frame held.
+ *  Until the buffer is full once, head is 0 and the frames are stored in order.
+ */
+class TemporalRingBuffer
+{
+public:
+    TemporalRingBuffer();
+    /*!
+     * \brief push Adds a frame as the newest one and drops the oldest one if the buffer is full.
+     * \param img Frame of any type, converted to 32bit float.
+     * \param capacity Number of frames held. If it changes, the newest frames are kept.
+     *  If the frame size or number of channels changes, the buffer starts over.
+     * \param dropped If not 0, receives a copy of the frame that was dropped (or is left empty).
+     */
+    void push(const cv::Mat &img, int capacity, cv::Mat *dropped = 0);
+    /*!
+     * \brief frame One frame as 1 row, without copying.
+     * \param position 0 for the oldest frame, size()-1 for the newest.
+     */
+    cv::Mat frame(int position) const;
+    /*!
+     * \brief stored Every frame held as 1 row each, in storage order (rotated by head once full), without copying.
+     */
+    cv::Mat stored() const;
+    /*!
+     * \brief copyLayout Allocates the buffer like another one, with the same head and size but unset frames.
+     */
+    void copyLayout(const TemporalRingBuffer &other);
+    int size() const;
+    int capacity() const;
+    bool full() const;
+    /*!
+     * \brief head Storage row of the oldest frame.
+     */
+    int head() const;
+    void clear();
+
+private:
+    // capacity rows, one frame each
+    cv::Mat data;
+    int oldest;
+    int count;
+};
+
+#endif // TEMPORALRINGBUFFER_H
@@ -28,6 +28,8 @@
 // FPS statistics queue lengths
 #define PROCESSING_FPS_STAT_QUEUE_LENGTH    32
 #define CAPTURE_FPS_STAT_QUEUE_LENGTH       32
+// Number of frames the stage timing percentiles are computed over
+#define STAGE_TIMING_WINDOW_LENGTH          128
 
 // Image buffer size
 #define DEFAULT_IMAGE_BUFFER_SIZE           1
@@ -43,6 +45,15 @@
 
 #define DEFAULT_LAP_MAG_EXAGGERATION        2.0
 #define DEFAULT_LAP_MAG_LEVELS              4
+// Chrominance attenuation below which Cr/Cb are only filtered from the second amplified level on
+#define LAP_MAG_REDUCED_CHROMA_ATTENUATION  0.25
+
+// Offline color magnification: series filtered together, one tile of the temporal cube
+#define OFFLINE_COLOR_TILE_SERIES           256
+
+// Breath extraction: number of largest regions averaged, and region count up to which nobody is breathing
+#define BREATH_NUM_REGIONS                  50
+#define BREATH_MIN_REGIONS                  7
 
 // General Default on Startup
 #define DEFAULT_GRAYSCALE                   false
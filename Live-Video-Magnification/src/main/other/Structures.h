@@ -28,6 +28,12 @@
 // Qt
 #include <QtCore/QRect>
 
+// Region detection of the BreathExtractor
+enum BreathMethod {
+    BREATH_CONTOURS = 0,    // cv::findContours, the original breath value
+    BREATH_COMPONENTS       // cv::connectedComponentsWithStats
+};
+
 struct ImageProcessingSettings{
     double amplification;
     double coWavelength;
@@ -40,6 +46,11 @@ struct ImageProcessingSettings{
     int levels;
     bool CSV;
     bool MagnifiedOrContours;
+    int breathMethod;
+    // Color only: estimate the dominant rate (pulse) from the spectrum of the temporal filter
+    bool rateEstimation;
+    // The magnification filters run on the average of every decimation frames, at framerate/decimation. 1 for every frame
+    int decimation;
 
     ImageProcessingSettings() :
         amplification(0.0),
@@ -52,7 +63,10 @@ struct ImageProcessingSettings{
         framerate(0.0),
         levels(4),
         CSV(false),
-        MagnifiedOrContours(false)
+        MagnifiedOrContours(false),
+        breathMethod(BREATH_CONTOURS),
+        rateEstimation(false),
+        decimation(1)
     {
     }
 };
@@ -62,12 +76,21 @@ struct ImageProcessingFlags{
     bool colorMagnifyOn;
     bool laplaceMagnifyOn;
     bool rieszMagnifyOn;
+    // Laplace only: compute the breath value, but no magnified image, contours or display
+    bool analysisOnlyOn;
+    // Color only: causal Butterworth bandpass per pixel instead of the ideal filter over a window
+    bool colorIirOn;
+    // Riesz only: pyramid from pyrDown/pyrUp Laplacian levels instead of the 9x9 filters
+    bool rieszFastOn;
 
     ImageProcessingFlags() :
         grayscaleOn(false),
         colorMagnifyOn(false),
         laplaceMagnifyOn(false),
-        rieszMagnifyOn(false)
+        rieszMagnifyOn(false),
+        analysisOnlyOn(false),
+        colorIirOn(false),
+        rieszFastOn(false)
     {
     }
 };
@@ -78,10 +101,43 @@ struct MouseData{
     bool rightButtonRelease;
 };
 
+// Stages of a magnification pipeline that are timed separately
+enum PipelineStage {
+    STAGE_PYRAMID = 0,      // buildLaplacePyrFromImg / buildGaussPyrFromImg / RieszPyramid::buildPyramid
+    STAGE_TEMPORAL,         // iirFilter / idealFilter / unwrapOrientPhase and RieszTemporalFilter::pass
+    STAGE_AMPLIFY,
+    STAGE_COLLAPSE,
+    STAGE_COLOR_CONVERSION, // 8bit <-> float and BGR <-> YCrCb
+    STAGE_BREATH,           // Contour based breath extraction
+    STAGE_TO_QIMAGE,        // MatToQImage
+    STAGE_COUNT
+};
+
 struct ThreadStatisticsData{
     int averageFPS;
     double nFramesProcessed;
     double averageVidProcessingFPS;
+    // Rolling percentiles of every PipelineStage in nanoseconds, 0 if the stage did not run
+    long long stageP50[STAGE_COUNT];
+    long long stageP95[STAGE_COUNT];
+    long long stageP99[STAGE_COUNT];
+    // Dominant rate of color magnification per minute and its confidence (0..1), 0 if not estimated
+    double ratePerMinute;
+    double rateConfidence;
+
+    ThreadStatisticsData() :
+        averageFPS(0),
+        nFramesProcessed(0),
+        averageVidProcessingFPS(0),
+        ratePerMinute(0),
+        rateConfidence(0)
+    {
+        for(int i = 0; i < STAGE_COUNT; ++i) {
+            stageP50[i] = 0;
+            stageP95[i] = 0;
+            stageP99[i] = 0;
+        }
+    }
 };
 
 #endif // STRUCTURES_H
@@ -77,47 +77,11 @@ void PlayerThread::run()
     qDebug() << "Starting player thread...";
     QElapsedTimer mTime;
 
-    // Shared memory init
-    HANDLE hMapFile;
-    LPCTSTR pBuf;
-
     int temp;
-    int *point2;
-    point2 = &temp;
-
-
-    TCHAR szName[]=TEXT("ReimaginingBreath");
-    TCHAR szMsg[]=TEXT("YOssage from first process.");
-
-
-    hMapFile = CreateFileMapping(
-        INVALID_HANDLE_VALUE,    // use paging file
-        NULL,                    // default security
-        PAGE_READWRITE,          // read/write access
-        0,                       // maximum object size (high-order DWORD)
-        BUF_SIZE,                // maximum object size (low-order DWORD)
-        szName);                 // name of mapping object
-
-    if (hMapFile == NULL)
-    {
-        _tprintf(TEXT("Could not create file mapping object (%d).\n"),
-                 GetLastError());
-    }
-    pBuf = (LPTSTR) MapViewOfFile(hMapFile,   // handle to map object
-                                  FILE_MAP_ALL_ACCESS, // read/write permission
-                                  0,
-                                  0,
-                                  BUF_SIZE);
-
-    if (pBuf == NULL)
-    {
-        _tprintf(TEXT("Could not map view of file (%d).\n"),
-                 GetLastError());
 
-        CloseHandle(hMapFile);
-    }
-
-    // end shared memory init
+    // Shared memory init
+    if(!breathChannel.create(BREATH_SOURCE_VIDEO))
+        qDebug() << "Could not create shared memory" << BREATH_CHANNEL_NAME;
 
     /////////////////////////////////////
     /// Stop thread if doStop=TRUE /////
@@ -274,7 +238,8 @@ void PlayerThread::run()
             temp = summ;
 
 
-            CopyMemory((PVOID)pBuf, point2, sizeof(int));
+            // 0 unless the rate is estimated
+            breathChannel.publish(temp, frameNum, magnificator.rateMeasureOutput, magnificator.rateConfidenceOutput);
 
             if (imgProcSettings.CSV) {
                 QFile file("out.csv");
@@ -286,7 +251,10 @@ void PlayerThread::run()
                     }
 
                     QTextStream outStream(&file);
-                    outStream << frameNum << "," << summ << "\n";
+                    outStream << frameNum << "," << summ;
+                    if(imgProcSettings.rateEstimation)
+                        outStream << "," << magnificator.rateMeasureOutput << "," << magnificator.rateConfidenceOutput;
+                    outStream << "\n";
 
                     file.close();
                 }
@@ -304,9 +272,17 @@ void PlayerThread::run()
 //                    1.0,
 //                    CV_RGB(118, 185, 0), //font color
 //                    2);
-        frame = MatToQImage(currentFrame);
+        // Breath value only: no frame is converted or shown
+        const bool analysisOnly = imgProcFlags.laplaceMagnifyOn && imgProcFlags.analysisOnlyOn;
+        if(!analysisOnly) {
+            std::chrono::steady_clock::time_point conversionStart = std::chrono::steady_clock::now();
+            frame = MatToQImage(currentFrame);
+            magnificator.stageTimer.add(STAGE_TO_QIMAGE, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - conversionStart).count());
+        }
         if(emitOriginal) {
-            originalFrame = MatToQImage(originalBuffer.front());
+            if(!analysisOnly)
+                originalFrame = MatToQImage(originalBuffer.front());
             if(!originalBuffer.empty()) {
                 originalBuffer.erase(originalBuffer.begin());
                 frameNum = 0;
@@ -318,15 +294,23 @@ void PlayerThread::run()
         ///////////////////////////////////
         /////////// Updating /////////////
         /////////////////////////////////
-        // Inform GUI thread of new frame
-        emit newFrame(frame);
-        // Inform GUI thread of original frame if option was set
-        if(emitOriginal)
-            emit origFrame(originalFrame);
+        if(!analysisOnly) {
+            // Inform GUI thread of new frame
+            emit newFrame(frame);
+            // Inform GUI thread of original frame if option was set
+            if(emitOriginal)
+                emit origFrame(originalFrame);
+        }
 
         // Update statistics
         updateFPS(processingTime);
         statsData.nFramesProcessed = currentWriteIndex;
+        // Settings updates clear the stage timer under processingMutex
+        processingMutex.lock();
+        magnificator.stageTimer.fillStatistics(statsData);
+        statsData.ratePerMinute = magnificator.rateMeasureOutput;
+        statsData.rateConfidence = magnificator.rateConfidenceOutput;
+        processingMutex.unlock();
         // Inform GUI about updatet statistics
         emit updateStatisticsInGUI(statsData);
 
@@ -335,9 +319,7 @@ void PlayerThread::run()
         int wait = max(delay-diff,0.0);
         this->msleep(wait);
     }
-    UnmapViewOfFile(pBuf);
-
-    CloseHandle(hMapFile);
+    breathChannel.close();
 
     qDebug() << "Stopping player thread...";
 }
@@ -485,6 +467,9 @@ void PlayerThread::updateImageProcessingFlags(struct ImageProcessingFlags imgPro
     this->imgProcFlags.colorMagnifyOn = imgProcessingFlags.colorMagnifyOn;
     this->imgProcFlags.laplaceMagnifyOn = imgProcessingFlags.laplaceMagnifyOn;
     this->imgProcFlags.rieszMagnifyOn = imgProcessingFlags.rieszMagnifyOn;
+    this->imgProcFlags.analysisOnlyOn = imgProcessingFlags.analysisOnlyOn;
+    this->imgProcFlags.colorIirOn = imgProcessingFlags.colorIirOn;
+    this->imgProcFlags.rieszFastOn = imgProcessingFlags.rieszFastOn;
     locker1.unlock();
     locker2.unlock();
 
@@ -495,16 +480,19 @@ void PlayerThread::updateImageProcessingSettings(struct ImageProcessingSettings
 {
     QMutexLocker locker1(&doStopMutex);
     QMutexLocker locker2(&processingMutex);
-    bool resetBuffer = (this->imgProcSettings.levels != imgProcessingSettings.levels);
+    bool resetBuffer = (this->imgProcSettings.levels != imgProcessingSettings.levels ||
+                        this->imgProcSettings.decimation != imgProcessingSettings.decimation);
 
     this->imgProcSettings.MagnifiedOrContours = imgProcessingSettings.MagnifiedOrContours;
     this->imgProcSettings.CSV = imgProcessingSettings.CSV;
+    this->imgProcSettings.rateEstimation = imgProcessingSettings.rateEstimation;
     this->imgProcSettings.amplification = imgProcessingSettings.amplification;
     this->imgProcSettings.coWavelength = imgProcessingSettings.coWavelength;
     this->imgProcSettings.coLow = imgProcessingSettings.coLow;
     this->imgProcSettings.coHigh = imgProcessingSettings.coHigh;
     this->imgProcSettings.chromAttenuation = imgProcessingSettings.chromAttenuation;
     this->imgProcSettings.levels = imgProcessingSettings.levels;
+    this->imgProcSettings.decimation = imgProcessingSettings.decimation;
 
     if(resetBuffer) {
         locker1.unlock();
@@ -645,9 +633,12 @@ void PlayerThread::setBufferSize()
     originalBuffer.clear();
     magnificator.clearBuffer();
 
-    if(imgProcFlags.colorMagnifyOn) {
+    if(imgProcFlags.colorMagnifyOn && !imgProcFlags.colorIirOn) {
         processingBufferLength = magnificator.getOptimalBufferSize(imgProcSettings.framerate);
     }
+    else if(imgProcFlags.colorMagnifyOn) {
+        processingBufferLength = 2;
+    }
     else if(imgProcFlags.laplaceMagnifyOn) {
         processingBufferLength = 2;
     }
@@ -24,19 +24,11 @@
 
 #ifndef PLAYERTHREAD_H
 #define PLAYERTHREAD_H
-#define BUF_SIZE 256
 
 // C++
 #include <cmath>
-// Windows/C++
-#include <windows.h>
-#include <stdio.h>
-#include <conio.h>
-#include <tchar.h>
-#include <memoryapi.h>
-#include <handleapi.h>
+#include <chrono>
 #include <iostream>
-#include <WinNT.h>
 
 // Qt
 #include <QtCore/QThread>
@@ -51,6 +43,7 @@
 #include "main/other/Config.h"
 #include "main/other/Structures.h"
 #include "main/helper/MatToQImage.h"
+#include "main/helper/BreathChannel.h"
 #include "main/magnification/Magnificator.h"
 
 // using namespace cv;
@@ -140,6 +133,7 @@ private:
         int breathValues[3];
         float prevSumm = 0;
         bool CSV;
+        BreathChannel breathChannel;
 
 
 protected:
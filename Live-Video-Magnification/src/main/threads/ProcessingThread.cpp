@@ -84,46 +84,11 @@ void ProcessingThread::run()
     //    timer.start(); do that here should work. Not sure if should emit it and make a signal, make it public, or what.
     // maybe reset timer before starting (if it was already going.)?
 
-    // Shared memory init
-    HANDLE hMapFile;
-    LPCTSTR pBuf;
-
     int temp = magnificator.breathMeasureOutput;
-    int *point2;
-    point2 = &temp;
-
-
-    // shared memory init
-    TCHAR szName[]=TEXT("ReimaginingBreath");
-
-
-    hMapFile = CreateFileMapping(
-        INVALID_HANDLE_VALUE,    // use paging file
-        NULL,                    // default security
-        PAGE_READWRITE,          // read/write access
-        0,                       // maximum object size (high-order DWORD)
-        BUF_SIZE,                // maximum object size (low-order DWORD)
-        szName);                 // name of mapping object
-
-    if (hMapFile == NULL)
-    {
-        _tprintf(TEXT("Could not create file mapping object (%d).\n"),
-                 GetLastError());
-    }
-    pBuf = (LPTSTR) MapViewOfFile(hMapFile,   // handle to map object
-                                  FILE_MAP_ALL_ACCESS, // read/write permission
-                                  0,
-                                  0,
-                                  BUF_SIZE);
 
-    if (pBuf == NULL)
-    {
-        _tprintf(TEXT("Could not map view of file (%d).\n"),
-                 GetLastError());
-
-        CloseHandle(hMapFile);
-    }
-    // end shared memory init
+    // Shared memory init
+    if(!breathChannel.create(deviceNumber))
+        qDebug() << "Could not create shared memory" << BREATH_CHANNEL_NAME;
     while(1)
     {
         ////////////////////////// ///////
@@ -150,6 +115,8 @@ void ProcessingThread::run()
         processingMutex.lock();
         // Get frame from queue, store in currentFrame, set ROI
         currentFrame=cv::Mat(sharedImageBuffer->getByDeviceNumber(deviceNumber)->get().clone(), currentROI);
+        // Breath value only: no frame is converted, recorded or shown
+        const bool analysisOnly = imgProcFlags.laplaceMagnifyOn && imgProcFlags.analysisOnlyOn;
 
         ////////////////////////// ///////// //
         // PERFORM IMAGE PROCESSING BELOW //
@@ -161,7 +128,7 @@ void ProcessingThread::run()
         }
 
         // Save the original Frame after grayscale conversion, so VideoWriter works correct
-        if(emitOriginal || captureOriginal)
+        if(!analysisOnly && (emitOriginal || captureOriginal))
             originalFrame = currentFrame.clone();
 
         // Fill Buffer that is processed by Magnificator
@@ -213,12 +180,17 @@ void ProcessingThread::run()
 
 
         // Convert cv::Mat to QImage
-        frame=MatToQImage(currentFrame);
+        if(!analysisOnly) {
+            std::chrono::steady_clock::time_point conversionStart = std::chrono::steady_clock::now();
+            frame=MatToQImage(currentFrame);
+            magnificator.stageTimer.add(STAGE_TO_QIMAGE, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - conversionStart).count());
+        }
 
         processingMutex.unlock();
 
         // Save the Stream
-        if(doRecord) {
+        if(doRecord && !analysisOnly) {
 
             if(output.isOpened()) {
                 if(captureOriginal) {
@@ -239,16 +211,24 @@ void ProcessingThread::run()
             }
         }
 
-        // Emit the original image before converting to grayscale
-        if(emitOriginal)
-            emit origFrame(MatToQImage(originalFrame));
-        // Inform GUI thread of new frame (QImage)
-        // emit newFrame(frame);
-        emit newFrame(MatToQImage(currentFrame));
+        if(!analysisOnly) {
+            // Emit the original image before converting to grayscale
+            if(emitOriginal)
+                emit origFrame(MatToQImage(originalFrame));
+            // Inform GUI thread of new frame (QImage)
+            // emit newFrame(frame);
+            emit newFrame(MatToQImage(currentFrame));
+        }
 
         // Update statistics
         updateFPS(processingTime);
         statsData.nFramesProcessed++;
+        // Settings updates clear the stage timer under processingMutex
+        processingMutex.lock();
+        magnificator.stageTimer.fillStatistics(statsData);
+        statsData.ratePerMinute = magnificator.rateMeasureOutput;
+        statsData.rateConfidence = magnificator.rateConfidenceOutput;
+        processingMutex.unlock();
         // Inform GUI of updated statistics
         emit updateStatisticsInGUI(statsData);
 
@@ -288,7 +268,8 @@ void ProcessingThread::run()
             temp = summ;
 
 
-            CopyMemory((PVOID)pBuf, point2, sizeof(int));
+            // Rate as snapshotted for the statistics, 0 unless it is estimated
+            breathChannel.publish(temp, frameNum, statsData.ratePerMinute, statsData.rateConfidence);
 
             if (imgProcSettings.CSV) {
                 QFile file("out.csv");
@@ -300,7 +281,10 @@ void ProcessingThread::run()
                     }
 
                     QTextStream outStream(&file);
-                    outStream << frameNum << "," << summ << "\n";
+                    outStream << frameNum << "," << summ;
+                    if(imgProcSettings.rateEstimation)
+                        outStream << "," << statsData.ratePerMinute << "," << statsData.rateConfidence;
+                    outStream << "\n";
 
                     file.close();
                 }
@@ -314,9 +298,7 @@ void ProcessingThread::run()
         // _getch();
     }
 
-    UnmapViewOfFile(pBuf);
-
-    CloseHandle(hMapFile);
+    breathChannel.close();
 
     qDebug() << "Stopping processing thread...";
 
@@ -390,6 +372,9 @@ void ProcessingThread::updateImageProcessingFlags(struct ImageProcessingFlags im
     this->imgProcFlags.colorMagnifyOn = imageProcessingFlags.colorMagnifyOn;
     this->imgProcFlags.laplaceMagnifyOn = imageProcessingFlags.laplaceMagnifyOn;
     this->imgProcFlags.rieszMagnifyOn = imageProcessingFlags.rieszMagnifyOn;
+    this->imgProcFlags.analysisOnlyOn = imageProcessingFlags.analysisOnlyOn;
+    this->imgProcFlags.colorIirOn = imageProcessingFlags.colorIirOn;
+    this->imgProcFlags.rieszFastOn = imageProcessingFlags.rieszFastOn;
     processingBuffer.clear();
     magnificator.clearBuffer();
 }
@@ -401,15 +386,19 @@ void ProcessingThread::updateImageProcessingSettings(struct ImageProcessingSetti
     this->imgProcSettings.amplification = imgProcessingSettings.amplification;
     this->imgProcSettings.MagnifiedOrContours = imgProcessingSettings.MagnifiedOrContours;
     this->imgProcSettings.CSV = imgProcessingSettings.CSV;
+    this->imgProcSettings.rateEstimation = imgProcessingSettings.rateEstimation;
     this->imgProcSettings.coWavelength = imgProcessingSettings.coWavelength;
     this->imgProcSettings.coLow = imgProcessingSettings.coLow;
     this->imgProcSettings.coHigh = imgProcessingSettings.coHigh;
     this->imgProcSettings.chromAttenuation = imgProcessingSettings.chromAttenuation;
-    if(this->imgProcSettings.levels != imgProcessingSettings.levels) {
+    // The filters restart for another pyramid or rate
+    if(this->imgProcSettings.levels != imgProcessingSettings.levels ||
+       this->imgProcSettings.decimation != imgProcessingSettings.decimation) {
         processingBuffer.clear();
         magnificator.clearBuffer();
     }
     this->imgProcSettings.levels = imgProcessingSettings.levels;
+    this->imgProcSettings.decimation = imgProcessingSettings.decimation;
 }
 
 void ProcessingThread::setROI(QRect roi)
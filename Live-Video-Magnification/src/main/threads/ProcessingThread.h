@@ -24,16 +24,9 @@
 
 #ifndef PROCESSINGTHREAD_H
 #define PROCESSINGTHREAD_H
-#define BUF_SIZE 256
-// Windows/C++
-#include <windows.h>
-#include <stdio.h>
-#include <conio.h>
-#include <tchar.h>
-#include <memoryapi.h>
-#include <handleapi.h>
+// C++
+#include <chrono>
 #include <iostream>
-#include <WinNT.h>
 
 // Qt
 #include <QtCore/QThread>
@@ -49,6 +42,7 @@
 #include "main/other/Buffer.h"
 #include "main/helper/MatToQImage.h"
 #include "main/helper/SharedImageBuffer.h"
+#include "main/helper/BreathChannel.h"
 #include "main/magnification/Magnificator.h"
 
 //using namespace cv;
@@ -112,6 +106,7 @@ class ProcessingThread : public QThread
         int breathValues[3];
         float prevSumm = 0;
         bool CSV;
+        BreathChannel breathChannel;
 
     protected:
         void run();
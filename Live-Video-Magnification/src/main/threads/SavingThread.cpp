@@ -49,7 +49,9 @@ SavingThread::~SavingThread()
 void SavingThread::run()
 {
     qDebug() << "Starting SavingThread thread";
-    while(1) {
+    // The whole file is there, so color magnification filters it at once instead of a window per frame
+    const bool offline = imgProcFlags.colorMagnifyOn && !imgProcFlags.colorIirOn && saveOfflineColor();
+    while(!offline) {
         ////////////////////////// /////// 
         // Stop thread if doStop=TRUE // 
         ////////////////////////// /////// 
@@ -146,6 +148,77 @@ void SavingThread::run()
     resetSaver();
 }
 
+bool SavingThread::saveOfflineColor()
+{
+    cv::Mat frame;
+    if(!readFrame(frame))
+        return false;
+    {
+        QMutexLocker locker(&processingMutex);
+        if(!magnificator.prepareOfflineColor(videoLength, frame)) {
+            // Start over, frame by frame
+            cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+            return false;
+        }
+    }
+
+    // 1. Decode the video once into the temporal cube, first half of the progress
+    int decoded = 0;
+    do {
+        if(stopRequested())
+            return true;
+        processingMutex.lock();
+        magnificator.addOfflineColorFrame(frame);
+        processingMutex.unlock();
+        ++decoded;
+        emit updateProgress(decoded/2);
+    } while(decoded < videoLength && readFrame(frame));
+
+    // 2. One DFT per series over all frames
+    processingMutex.lock();
+    const int frames = magnificator.filterOfflineColor();
+    processingMutex.unlock();
+
+    // 3. Read the originals again, magnify and write them, second half of the progress
+    cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+    for(currentWriteIndex = 0; currentWriteIndex < frames && readFrame(frame); ) {
+        if(stopRequested())
+            break;
+        processingMutex.lock();
+        processedFrame = magnificator.offlineColorFrame(frame, currentWriteIndex);
+        if(captureOriginal)
+            mergedFrame = combineFrames(processedFrame, frame);
+        processingMutex.unlock();
+
+        if(out.isOpened())
+            out.write(captureOriginal ? mergedFrame : processedFrame);
+        currentWriteIndex++;
+        emit updateProgress((frames + currentWriteIndex)/2);
+    }
+
+    processingMutex.lock();
+    magnificator.releaseOfflineColor();
+    processingMutex.unlock();
+    return true;
+}
+
+bool SavingThread::readFrame(cv::Mat &frame)
+{
+    if(!cap.read(grabbedFrame))
+        return false;
+    frame = cv::Mat(grabbedFrame.clone(), ROI);
+    if(imgProcFlags.grayscaleOn && (frame.channels() == 3 || frame.channels() == 4)) {
+        cvtColor(frame, frame, cv::COLOR_BGR2GRAY, 1);
+    }
+    return true;
+}
+
+bool SavingThread::stopRequested()
+{
+    QMutexLocker locker(&doStopMutex);
+    return doStop;
+}
+
 void SavingThread::resetSaver()
 {
     QMutexLocker locker1(&doStopMutex);
@@ -188,9 +261,12 @@ void SavingThread::settings(ImageProcessingFlags imageProcFlags, ImageProcessing
 
 bool SavingThread::saveFile(std::string destination, double framerate, QRect dimensions, bool captureOriginal)
 {
-    if(imgProcFlags.colorMagnifyOn) {
+    if(imgProcFlags.colorMagnifyOn && !imgProcFlags.colorIirOn) {
         processingBufferLength = magnificator.getOptimalBufferSize(framerate);
     }
+    else if(imgProcFlags.colorMagnifyOn) {
+        processingBufferLength = 2;
+    }
     else if(imgProcFlags.laplaceMagnifyOn) {
         processingBufferLength = 2;
     }
@@ -77,6 +77,11 @@ private:
     int currentWriteIndex;
     int getCurrentReadIndex();
     cv::Mat combineFrames(cv::Mat &frame1, cv::Mat &frame2);
+    // Reads the next frame of the ROI, converted to grayscale if needed
+    bool readFrame(cv::Mat &frame);
+    // Color magnification of the whole file at once, false if it has to be done frame by frame
+    bool saveOfflineColor();
+    bool stopRequested();
     // Magnify
     Magnificator magnificator;
     ImageProcessingFlags imgProcFlags;
@@ -211,6 +211,9 @@ void CameraView::updateProcessingThreadStats(struct ThreadStatisticsData statDat
                           QString("x")+QString::number(processingThread->getCurrentROI().height()));
     // Show number of frames processed in nFramesProcessedLabel
     ui->nFramesProcessedLabel->setText(QString("[") + QString::number(statData.nFramesProcessed) + QString("]"));
+
+    // Show p50/p95/p99 of every stage that ran in stageTimingsLabel
+    ui->stageTimingsLabel->setText(StageTimer::formatStageTimings(statData));
 }
 
 void CameraView::updateFrame(const QImage &frame)
@@ -49,6 +49,7 @@ MagnifyOptions::MagnifyOptions(QWidget *parent) :
     connect(ui->AmplificationSpinBox, SIGNAL(valueChanged(int)), SLOT(updateSettingsFromOptionsTab()));
     connect(ui->COWavelengthSpinBox, SIGNAL(valueChanged(double)), SLOT(updateSettingsFromOptionsTab()));
     connect(ui->LevelsSpinBox, SIGNAL(valueChanged(int)), SLOT(updateSettingsFromOptionsTab()));
+    connect(ui->DecimationSpinBox, SIGNAL(valueChanged(int)), SLOT(updateSettingsFromOptionsTab()));
 
     // Update Spinbox
     connect(ui->COWavelengthSlider, SIGNAL(valueChanged(int)), this, SLOT(convertFromSlider(int)));
@@ -67,6 +68,10 @@ MagnifyOptions::MagnifyOptions(QWidget *parent) :
     connect(ui->grayscaleCheckBox, SIGNAL(clicked()), SLOT(updateFlagsFromOptionsTab()));
 
     connect(ui->CSVOutput, SIGNAL(clicked()), SLOT(updateSettingsFromOptionsTab()));
+    connect(ui->AnalysisOnlyCheckBox, SIGNAL(clicked()), SLOT(updateFlagsFromOptionsTab()));
+    connect(ui->CausalColorCheckBox, SIGNAL(clicked()), SLOT(updateFlagsFromOptionsTab()));
+    connect(ui->RateCheckBox, SIGNAL(clicked()), SLOT(updateSettingsFromOptionsTab()));
+    connect(ui->FastRieszCheckBox, SIGNAL(clicked()), SLOT(updateFlagsFromOptionsTab()));
 //    connect(ui->MagnifiedOrContours, SIGNAL(clicked()), SLOT(reset()));
 
     // Initialize Settings with Default values
@@ -208,6 +213,7 @@ void MagnifyOptions::reset()
         break;
     default:  
         ui->LevelsSpinBox->setDisabled(true);
+        ui->DecimationSpinBox->setDisabled(true);
         ui->verticalSpacer->changeSize(0,0,QSizePolicy::Maximum, QSizePolicy::Maximum);
 
         ui->AmplificationLabel->hide();
@@ -238,6 +244,10 @@ void MagnifyOptions::reset()
         ui->HzSpacer->hide();
 
         ui->CSVOutput->hide();
+        ui->AnalysisOnlyCheckBox->hide();
+        ui->CausalColorCheckBox->hide();
+        ui->RateCheckBox->hide();
+        ui->FastRieszCheckBox->hide();
         ui->MagnifiedOrContours->hide();
         ui->resetButton->hide();
 
@@ -258,6 +268,12 @@ void MagnifyOptions::updateFlagsFromOptionsTab()
     imgProcFlags.colorMagnifyOn = (ui->MagnifcationtypeComboBox->currentIndex() == 1);
     imgProcFlags.laplaceMagnifyOn = (ui->MagnifcationtypeComboBox->currentIndex() == 2);
     imgProcFlags.rieszMagnifyOn = (ui->MagnifcationtypeComboBox->currentIndex() == 3);
+    // Only the breath value, no magnified image
+    imgProcFlags.analysisOnlyOn = ui->AnalysisOnlyCheckBox->isChecked();
+    // Causal color magnification, no window of frames
+    imgProcFlags.colorIirOn = ui->CausalColorCheckBox->isChecked();
+    // Riesz pyramid from Laplacian levels
+    imgProcFlags.rieszFastOn = ui->FastRieszCheckBox->isChecked();
 
     emit newImageProcessingFlags(imgProcFlags);
 }
@@ -281,6 +297,8 @@ void MagnifyOptions::updateSettingsFromOptionsTab()
         ui->loBpm->setText(loBpm);
         ui->hiBpm->setText(hiBpm);
 
+        imgProcSettings.rateEstimation = ui->RateCheckBox->isChecked();
+
         imgProcSettings.chromAttenuation = ui->ChromSpinBox->value()/100.0;
         imgProcSettings.levels = ui->LevelsSpinBox->value();
     }
@@ -307,6 +325,8 @@ void MagnifyOptions::updateSettingsFromOptionsTab()
         imgProcSettings.coHigh = ui->COHighDoubleSpinBox->value();
         imgProcSettings.levels = ui->LevelsSpinBox->value();
     }
+    // Every magnification can run at a reduced rate
+    imgProcSettings.decimation = ui->DecimationSpinBox->value();
 
     emit newImageProcessingSettings(imgProcSettings);
 }
@@ -324,6 +344,7 @@ ImageProcessingFlags MagnifyOptions::getFlags()
 void MagnifyOptions::applyColorInterface()
 {
     ui->LevelsSpinBox->setDisabled(false);
+    ui->DecimationSpinBox->setDisabled(false);
     ui->verticalSpacer->changeSize(0,20,QSizePolicy::Maximum, QSizePolicy::Maximum);
 
     doubleSlider->setMaximum(300);
@@ -361,11 +382,16 @@ void MagnifyOptions::applyColorInterface()
     ui->DoubleSliderValLabel->setText("Hz");
 
     ui->resetButton->show();
+    ui->AnalysisOnlyCheckBox->hide();
+    ui->CausalColorCheckBox->show();
+    ui->RateCheckBox->show();
+    ui->FastRieszCheckBox->hide();
 }
 
 void MagnifyOptions::applyLaplaceInterface()
 {
     ui->LevelsSpinBox->setDisabled(false);
+    ui->DecimationSpinBox->setDisabled(false);
     ui->verticalSpacer->changeSize(0,20,QSizePolicy::Maximum, QSizePolicy::Maximum);
 
     doubleSlider->setMaximum(100);
@@ -407,12 +433,17 @@ void MagnifyOptions::applyLaplaceInterface()
 
     ui->resetButton->show();
     ui->CSVOutput->show();
+    ui->AnalysisOnlyCheckBox->show();
+    ui->CausalColorCheckBox->hide();
+    ui->RateCheckBox->hide();
+    ui->FastRieszCheckBox->hide();
     ui->MagnifiedOrContours->show();
 }
 
 void MagnifyOptions::applyRieszInterface()
 {
     ui->LevelsSpinBox->setDisabled(false);
+    ui->DecimationSpinBox->setDisabled(false);
     ui->verticalSpacer->changeSize(0,20,QSizePolicy::Maximum, QSizePolicy::Maximum);
 
     ui->AmplificationLabel->show();
@@ -454,6 +485,10 @@ void MagnifyOptions::applyRieszInterface()
     ui->DoubleSliderValLabel->setText("Hz");
 
     ui->resetButton->show();
+    ui->AnalysisOnlyCheckBox->hide();
+    ui->CausalColorCheckBox->hide();
+    ui->RateCheckBox->hide();
+    ui->FastRieszCheckBox->show();
 }
 
 void MagnifyOptions::toggleGrayscale(bool isActive)
@@ -213,6 +213,9 @@ void VideoView::updatePlayerThreadStats(struct ThreadStatisticsData statData)
                           QString::number(playerThread->getCurrentROI().y())+QString(") ")+
                           QString::number(playerThread->getCurrentROI().width())+
                           QString("x")+QString::number(playerThread->getCurrentROI().height()));
+
+    // Show p50/p95/p99 of every stage that ran in stageTimingsLabel
+    ui->stageTimingsLabel->setText(StageTimer::formatStageTimings(statData));
 }
 
 void VideoView::updateFrame(const QImage &frame)
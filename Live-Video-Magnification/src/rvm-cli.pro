@@ -0,0 +1,67 @@
+# Headless command line magnifier. Shares the magnification sources with rvm.pro,
+# but links neither QtGui nor QtWidgets.
+QT = core
+
+CONFIG += console
+CONFIG -= app_bundle
+
+linux {
+###################################################################
+# !! Not tested, change to match your OpenCV (>= v4) installation #
+    QT_CONFIG -= no-pkg-config
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv4
+# !! Not tested, change to match your OpenCV (>= v4) installation #
+###################################################################
+}
+
+win32 {
+    ##########################################################################
+    # !! Change this to match your OpenCV (>= v4) installation on Windows !! #
+    INCLUDEPATH += C:\opencv\opencv-build\install\include
+    LIBS += C:\opencv\opencv-build\bin\libopencv_core460.dll
+    LIBS += C:\opencv\opencv-build\bin\libopencv_highgui460.dll
+    LIBS += C:\opencv\opencv-build\bin\libopencv_imgcodecs460.dll
+    LIBS += C:\opencv\opencv-build\bin\libopencv_imgproc460.dll
+    LIBS += C:\opencv\opencv-build\bin\libopencv_videoio460.dll
+    LIBS += -L"C:\opencv\opencv-build\install\x64\mingw\bin"
+    # !! Change this to match your OpenCV (>= v4) installation on Windows !! #
+    ##########################################################################
+
+    CONFIG -= debug_and_release debug_and_release_target
+}
+
+TARGET = rvm-cli
+TEMPLATE = app
+
+DEFINES += APP_VERSION=\\\"1.0\\\"
+
+INCLUDEPATH += $$PWD/main \
+    $$PWD/main/helper \
+    $$PWD/main/magnification \
+    $$PWD/main/other
+
+SOURCES += main/cli/CliMain.cpp \
+    main/helper/StageTimer.cpp \
+    main/magnification/BreathExtractor.cpp \
+    main/magnification/LaplacePyramid.cpp \
+    main/magnification/Magnificator.cpp \
+    main/magnification/RieszPyramid.cpp \
+    main/magnification/SpatialFilter.cpp \
+    main/magnification/TemporalCube.cpp \
+    main/magnification/TemporalFilter.cpp \
+    main/magnification/TemporalRingBuffer.cpp
+
+HEADERS += \
+    main/helper/ComplexMat.h \
+    main/helper/StageTimer.h \
+    main/magnification/BreathExtractor.h \
+    main/magnification/LaplacePyramid.h \
+    main/magnification/Magnificator.h \
+    main/magnification/RieszPyramid.h \
+    main/magnification/SpatialFilter.h \
+    main/magnification/TemporalCube.h \
+    main/magnification/TemporalFilter.h \
+    main/magnification/TemporalRingBuffer.h \
+    main/other/Config.h \
+    main/other/Structures.h
@@ -5,7 +5,9 @@ linux {
 # !! Not tested, change to match your Open` (>= v4) installation #
     QT_CONFIG -= no-pkg-config
     CONFIG += link_pkgconfig
-    PKGCONFIG += opencv
+    PKGCONFIG += opencv4
+    # shm_open for the breath channel
+    LIBS += -lrt
 # !! Not tested, change to match your OpenCV (>= v4) installation #
 ###################################################################
 }
@@ -72,12 +74,18 @@ INCLUDEPATH += $$PWD/main \
     $$PWD/external/qxtSlider
 
 SOURCES += main/main.cpp \
+    main/helper/BreathChannel.cpp \
     main/helper/MatToQImage.cpp \
     main/helper/SharedImageBuffer.cpp \
+    main/helper/StageTimer.cpp \
+    main/magnification/BreathExtractor.cpp \
+    main/magnification/LaplacePyramid.cpp \
     main/magnification/Magnificator.cpp \
     main/magnification/RieszPyramid.cpp \
     main/magnification/SpatialFilter.cpp \
+    main/magnification/TemporalCube.cpp \
     main/magnification/TemporalFilter.cpp \
+    main/magnification/TemporalRingBuffer.cpp \
     main/threads/CaptureThread.cpp \
     main/threads/PlayerThread.cpp \
     main/threads/ProcessingThread.cpp \
@@ -92,13 +100,19 @@ SOURCES += main/main.cpp \
     external/qxtSlider/qxtspanslider.cpp
 
 HEADERS += \
+    main/helper/BreathChannel.h \
     main/helper/ComplexMat.h \
     main/helper/MatToQImage.h \
     main/helper/SharedImageBuffer.h \
+    main/helper/StageTimer.h \
+    main/magnification/BreathExtractor.h \
+    main/magnification/LaplacePyramid.h \
     main/magnification/Magnificator.h \
     main/magnification/RieszPyramid.h \
     main/magnification/SpatialFilter.h \
+    main/magnification/TemporalCube.h \
     main/magnification/TemporalFilter.h \
+    main/magnification/TemporalRingBuffer.h \
     main/threads/CaptureThread.h \
     main/threads/PlayerThread.h \
     main/threads/ProcessingThread.h \
@@ -1,18 +1,44 @@
 # via https://stackoverflow.com/questions/71479189/shared-memory-ipc-solution-for-both-linux-and-windows
+# Layout is defined in Live-Video-Magnification/src/main/helper/BreathChannel.h
+import struct
+import time
 from multiprocessing import shared_memory
 
+HEADER = struct.Struct("<i12xIIIIQQ")  # legacy value, magic, version, capacity, sample size, sequence, written
+SAMPLE = struct.Struct("<qqiiff")      # timestamp ns, frame number, value, source (camera, -1 for video),
+                                       # rate per minute and its confidence (0 unless estimated)
+MAGIC = 0x52425248
+VERSION = 3
+READ_RETRIES = 1000   # BREATH_CHANNEL_READ_RETRIES
+
+def read_since(buf, cursor):
+    # Seqlock read: retry while the writer is busy (odd sequence) or wrote in between.
+    # Gives up (no samples, cursor unchanged) if the segment isn't initialized yet or the writer
+    # doesn't finish a sample, e.g. because it died, so the caller can try again later
+    for attempt in range(READ_RETRIES):
+        if attempt > 0:
+            time.sleep(0)
+        legacy, magic, version, capacity, sample_size, seq, written = HEADER.unpack_from(buf, 0)
+        if magic != MAGIC or version != VERSION:
+            return [], cursor
+        if seq & 1:
+            continue
+        first = max(min(cursor, written), written - capacity)
+        samples = [SAMPLE.unpack_from(buf, HEADER.size + (i % capacity) * sample_size)
+                   for i in range(first, written)]
+        if HEADER.unpack_from(buf, 0)[5] == seq:
+            return samples, written
+    return [], cursor
+
 def main():
   # create=false, use existing
-  # 10 is the # bytes, likely to change
-  shm_a = shared_memory.SharedMemory(name="ReimaginingBreath", size=10)
-  prevValue = 0
+  shm_a = shared_memory.SharedMemory(name="ReimaginingBreath")
+  cursor = 0
   while 1:
-    # Reads in byte array, convert that to integer using little endian.
-    temp = int.from_bytes(bytes(shm_a.buf[:10]), 'little')
-    # print("temp: ", temp, "Prev: ", prevValue)
-    if  temp != prevValue:
-        print(temp)
-        prevValue = temp
+    samples, cursor = read_since(shm_a.buf, cursor)
+    for timestamp, frame, value, source, rate, confidence in samples:
+        print(source, frame, value, timestamp, rate, confidence)
+    time.sleep(0.1)
 
   shm_a.close()
 